@@ -44,6 +44,7 @@
 #include "i_random.h"
 #include "m_misc.h"
 #include "m_menu.h"
+#include "m_bench.h"
 
 #include "i_system.h"
 #include "i_sound.h"
@@ -107,7 +108,12 @@ boolean nearSprites;
 boolean monoSound;
 boolean noMelt;
 
+#if defined(USE_BACKBUFFER)
+boolean overdrawRender;
+#endif
+
 boolean reverseStereo;
+boolean accumMix;
 
 boolean forceHighDetail;
 boolean forceLowDetail;
@@ -151,6 +157,13 @@ boolean busSpeed;
 boolean waitVsync;
 
 boolean singletics = false; // debug flag to cancel adaptiveness
+boolean nodrawers = false;
+boolean checksumparm = false;
+boolean memsaveparm = false;
+boolean visparm = false;
+boolean pvsparm = false;
+int warptic = 0;
+boolean warping = false;
 boolean benchmark = false;
 boolean benchmark_finished = false;
 boolean benchmark_commandline = false;
@@ -166,6 +179,11 @@ int benchmark_total = 0;
 char **benchmark_files;
 unsigned int benchmark_files_num = 0;
 unsigned int benchmark_total_tics = 0;
+char benchmark_demos[BENCHMARK_MAXDEMOS][13];
+unsigned int benchmark_demos_num = 0;
+int benchmark_repeat = 1;
+int benchmark_warmup = 0;
+int benchmark_repetition = 0;
 
 extern int sfxVolume;
 extern int musicVolume;
@@ -464,11 +482,13 @@ void D_Display(void)
             I_WaitSingleVBL();
 #endif
 
+        I_Trace(TRACE_STAGE_BEGIN, TRACE_STAGE_FINISH, 0);
 #if defined(MODE_13H)
         finishfunc();
 #else
         I_FinishUpdate(); // page flip or blit buffer
 #endif
+        I_Trace(TRACE_STAGE_END, TRACE_STAGE_FINISH, 0);
 
         if (showFPS)
             I_CalculateFPS();
@@ -525,6 +545,10 @@ extern byte demorecording;
 unsigned int frametime_position = 0;
 unsigned int *frametime;
 
+#if (RENDERSTATS_ENABLED == 1)
+renderstats_t *framestats;
+#endif
+
 void D_DoomLoop(void)
 {
     if (demorecording)
@@ -570,7 +594,36 @@ void D_DoomLoop(void)
         }
 
         // Update display, next frame, with current state.
-        D_Display();
+        if (!warping)
+        {
+            I_Trace(TRACE_STAGE_BEGIN, TRACE_STAGE_DISPLAY, 0);
+            D_Display();
+            I_Trace(TRACE_STAGE_END, TRACE_STAGE_DISPLAY, 0);
+        }
+    }
+}
+
+//
+// D_DoomLoopNoDraw
+// Runs every demo tic as fast as possible, without D_Display
+//
+void D_DoomLoopNoDraw(void)
+{
+    I_InitGraphics();
+
+    while (1)
+    {
+        I_StartTic();
+        D_ProcessEvents();
+        G_BuildTiccmd(&localcmds[maketic & (BACKUPTICS - 1)]);
+        if (advancedemo)
+            D_DoAdvanceDemo();
+        G_Ticker();
+        gametic++;
+        maketic++;
+
+        // Does nothing with -nosound
+        S_UpdateSounds();
     }
 }
 
@@ -582,7 +635,11 @@ void D_DoomLoopBenchmark(void)
 
     while (1)
     {
-        start_time = mscount;
+        start_time = TS_GetClocks();
+
+#if (RENDERSTATS_ENABLED == 1)
+        SetDWords(&renderstats, 0, sizeof(renderstats) / 4);
+#endif
 
         // process one or more tics
         I_StartTic();
@@ -612,12 +669,21 @@ void D_DoomLoopBenchmark(void)
                 break;
         }
 
+        // Frames are neither drawn nor timed while warping
+        if (warping)
+            continue;
+
         // Update display, next frame, with current state.
+        I_Trace(TRACE_STAGE_BEGIN, TRACE_STAGE_DISPLAY, 0);
         D_Display();
+        I_Trace(TRACE_STAGE_END, TRACE_STAGE_DISPLAY, 0);
 
-        end_time = mscount - start_time;
+        end_time = TS_GetClocks() - start_time;
 
-        frametime[frametime_position] = end_time;
+        frametime[frametime_position] = FixedMul(end_time, TS_MicrosecondsPerClock);
+#if (RENDERSTATS_ENABLED == 1)
+        framestats[frametime_position] = renderstats;
+#endif
         frametime_position++;
     }
 }
@@ -1199,25 +1265,6 @@ unsigned char SelectIBMCGA(void)
 
 char demofile[13];
 
-int D_FileGetFirstInteger(const char* filename) {
-    char buffer[1024];
-    int firstInteger = -1;
-
-    FILE* file = fopen(filename, "r");
-
-    if (file == NULL)
-        return -1;
-
-    if (fgets(buffer, sizeof(buffer), file) != NULL) {
-        if (sscanf(buffer, "%u", &firstInteger) != 1) {
-            firstInteger = -1;
-        }
-    }
-
-    fclose(file);
-    return firstInteger;
-}
-
 void D_GetListBenchFiles(void) {
     struct find_t ffblk;
     char search[20];
@@ -1341,8 +1388,22 @@ void D_DoomMain(void)
 
     singletics = M_CheckParm("-singletics");
 
+    nodrawers = M_CheckParm("-nodraw");
+
+    checksumparm = M_CheckParm("-checksum");
+
+    memsaveparm = M_CheckParm("-memsave");
+
+    visparm = M_CheckParm("-vis");
+    pvsparm = M_CheckParm("-pvs");
+
+    if ((p = M_CheckParm("-warptic")) && p < myargc - 1)
+        warptic = atoi(myargv[p + 1]);
+
     reverseStereo = M_CheckParm("-reverseStereo");
 
+    accumMix = M_CheckParm("-accumMix");
+
     csv = M_CheckParm("-csv");
 
     benchmark_advanced = M_CheckParm("-advanced");
@@ -1355,17 +1416,57 @@ void D_DoomMain(void)
         benchmark_commandline = true;
         csv = 1;
 
-        sprintf(demofile, "%s", myargv[p + 2]);
-        D_AddFile(demofile);
+        // Comma separated list of demos, all of them run on every setting
+        {
+            char demolist[128];
+            char *token;
+
+            sprintf(demolist, "%.127s", myargv[p + 2]);
+
+            for (token = strtok(demolist, ","); token != NULL && benchmark_demos_num < BENCHMARK_MAXDEMOS; token = strtok(NULL, ","))
+            {
+                sprintf(benchmark_demos[benchmark_demos_num], "%.12s", token);
+                D_AddFile(benchmark_demos[benchmark_demos_num]);
+                benchmark_demos_num++;
+            }
+
+            sprintf(demofile, "%s", benchmark_demos[0]);
+        }
 
         if(!strcmp(myargv[p + 1], "file"))
         {
-            benchmark_total = D_FileGetFirstInteger(myargv[p + 3]);
+            benchmark_total = M_CountBenchmarkFile(myargv[p + 3]);
+
+            if (benchmark_total < 0)
+                I_Error("Benchmark file %s not found", myargv[p + 3]);
+
+            benchmark_total *= benchmark_demos_num;
             benchmark_type = 1;
             sprintf(benchmark_file, "%s", myargv[p + 3]);
         }
         if(!strcmp(myargv[p + 1], "single"))
+        {
+            benchmark_total = benchmark_demos_num;
             benchmark_type = 0;
+        }
+
+        if ((p = M_CheckParm("-repeat")))
+        {
+            if (p < myargc - 1)
+                benchmark_repeat = atoi(myargv[p + 1]);
+            if (benchmark_repeat < 1)
+                benchmark_repeat = 1;
+            else if (benchmark_repeat > BENCHMARK_MAXREPEAT)
+                benchmark_repeat = BENCHMARK_MAXREPEAT;
+        }
+
+        if ((p = M_CheckParm("-warmup")))
+        {
+            if (p < myargc - 1)
+                benchmark_warmup = atoi(myargv[p + 1]);
+            if (benchmark_warmup < 0)
+                benchmark_warmup = 0;
+        }
     }
 
     disableDemo = M_CheckParm("-disabledemo");
@@ -1516,6 +1617,14 @@ void D_DoomMain(void)
         screenblocks = forceScreenSize;
     }
 
+    if ((p = M_CheckParm("-channels")) && p < myargc - 1)
+        numChannels = atoi(myargv[p + 1]);
+
+    if (numChannels < 1)
+        numChannels = 1;
+    else if (numChannels > MAX_CHANNELS)
+        numChannels = MAX_CHANNELS;
+
 
 
     M_CheckParmOptionalValue("-flatSpan", &visplaneRender, VISPLANES_FLAT);
@@ -1553,6 +1662,10 @@ void D_DoomMain(void)
     M_CheckParmDisable("-novsync", &waitVsync);
     M_CheckParmDisable("-nofps", &showFPS);
 
+#if defined(USE_BACKBUFFER)
+    overdrawRender = M_CheckParm("-overdraw");
+#endif
+
 #if defined(MODE_T8025) || defined(MODE_T8050) || defined(MODE_T8043) || defined(MODE_T4025) || defined(MODE_T4050) || defined(MODE_MDA)
     noMelt = 1;
 #endif
@@ -1623,6 +1736,10 @@ void D_DoomMain(void)
     if (p && p < myargc - 1)
     {
         G_TimeDemo(myargv[p + 1]);
+
+        if (nodrawers)
+            D_DoomLoopNoDraw(); // never returns
+
         D_DoomLoop(); // never returns
     }
 
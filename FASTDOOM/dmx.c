@@ -32,9 +32,11 @@
 #include "ns_muldf.h"
 #include "i_sound.h"
 #include "m_misc.h"
+#include "z_zone.h"
 #include "options.h"
 #include "i_system.h"
 #include "i_sound.h"
+#include "fastmath.h"
 
 typedef struct
 {
@@ -56,74 +58,82 @@ int pcshandle = 0;
 fx_blaster_config dmx_blaster;
 
 void *mus_data = NULL;
-char *mid_data = NULL;
+
+// Songs converted from MUS, kept in the zone per lump. The playing one
+// is PU_MUSIC, the rest PU_CACHE so they stay until the memory is needed.
+#define MIDICACHE_SIZE 16
+
+typedef struct
+{
+    byte *data; // NULL once purged
+    int lumpnum;
+} midicache_t;
+
+midicache_t midicache[MIDICACHE_SIZE];
+int midicachenext = 0;
+int midiplaying = -1;
 
 int mus_loop = 0;
 int dmx_mus_port = 0;
 int dmx_snd_port = 0;
 
-int MUS_RegisterSong(void *data)
+int MUS_RegisterSong(void *data, int lumpnum)
 {
-    FILE *mus;
-    FILE *mid;
+    unsigned int muslen;
     unsigned int midlen;
-    unsigned short len;
+    int i;
+
     mus_data = NULL;
-    len = ((unsigned short *)data)[2] + ((unsigned short *)data)[3];
-    if (mid_data)
+
+    if (midiplaying != -1 && midicache[midiplaying].data)
     {
-        free(mid_data);
+        Z_ChangeTag(midicache[midiplaying].data, PU_CACHE);
     }
-    if (memcmp(data, "MThd", 4))
+    midiplaying = -1;
+
+    if (!memcmp(data, "MThd", 4))
     {
-        mus = fopen("temp.mus", "wb");
-        if (!mus)
-        {
-            return 0;
-        }
-        fwrite(data, 1, len, mus);
-        fclose(mus);
-        mus = fopen("temp.mus", "rb");
-        if (!mus)
-        {
-            return 0;
-        }
-        mid = fopen("temp.mid", "wb");
-        if (!mid)
-        {
-            fclose(mus);
-            return 0;
-        }
-        if (mus2mid(mus, mid))
+        mus_data = data;
+        return 0;
+    }
+
+    for (i = 0; i < MIDICACHE_SIZE; i++)
+    {
+        if (midicache[i].data && midicache[i].lumpnum == lumpnum)
         {
-            fclose(mid);
-            fclose(mus);
-            return 0;
+            break;
         }
-        fclose(mid);
-        fclose(mus);
-        mid = fopen("temp.mid", "rb");
-        if (!mid)
+    }
+
+    if (i == MIDICACHE_SIZE)
+    {
+        // Size it first, then convert straight into the cache
+        muslen = ((unsigned short *)data)[2] + ((unsigned short *)data)[3];
+        midlen = mus2mid(data, muslen, NULL);
+        if (!midlen)
         {
             return 0;
         }
-        fseek(mid, 0, SEEK_END);
-        midlen = ftell(mid);
-        rewind(mid);
-        mid_data = malloc(midlen);
-        if (!mid_data)
+
+        i = midicachenext;
+        midicachenext = (midicachenext + 1) & (MIDICACHE_SIZE - 1);
+
+        if (midicache[i].data)
         {
-            fclose(mid);
-            return 0;
+            Z_Free(midicache[i].data);
         }
-        fread(mid_data, 1, midlen, mid);
-        fclose(mid);
-        mus_data = mid_data;
-        remove("temp.mid");
-        remove("temp.mus");
-        return 0;
+
+        Z_Malloc(midlen, PU_MUSIC, &midicache[i].data);
+        mus2mid(data, muslen, midicache[i].data);
+        midicache[i].lumpnum = lumpnum;
+    }
+    else
+    {
+        Z_ChangeTag(midicache[i].data, PU_MUSIC);
     }
-    mus_data = data;
+
+    midiplaying = i;
+    mus_data = midicache[i].data;
     return 0;
 }
 int MUS_ChainSong(int handle, int next)
@@ -143,7 +153,148 @@ void MUS_PlaySong(int handle, int volume)
     MUSIC_SetVolume(volume);
 }
 
-int SFX_PlayPatch(void *vdata, int sep, int vol)
+// Sound effects converted to the mix rate on first use, so the mixer
+// plays them without stepping. They are PU_SOUND during a level and
+// PU_CACHE between levels, snd_sfxcache is the budget in KB for the
+// PU_SOUND ones. A purged sound is converted again on its next use.
+static unsigned int sfxcacheused = 0;
+
+#define SFX_PatchSize(data) (((data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4]) + 8)
+
+int SFX_CachePatch(void **vdata)
+{
+    unsigned char *data = (unsigned char *)*vdata;
+    unsigned char *dest;
+    unsigned int type = data[0] | (data[1] << 8);
+    unsigned long rate;
+    unsigned long mixrate;
+    unsigned long len;
+    unsigned long newlen;
+    unsigned long step;
+    unsigned long frac;
+    unsigned long i;
+
+    mixrate = MV_GetMixRate();
+    if (type != 3 || !mixrate)
+    {
+        return 0;
+    }
+
+    rate = (data[3] << 8) | data[2];
+    len = (data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4];
+    if (len <= 48 || rate == mixrate)
+    {
+        return 0;
+    }
+    len -= 32;
+
+    // Same stepping as the mixer, the sound plays back unchanged
+    step = (rate << 16) / mixrate;
+    if (!step)
+    {
+        return 0;
+    }
+
+    newlen = 0;
+    for (i = 0, frac = 0; i < len; newlen++)
+    {
+        frac += step;
+        i += frac >> 16;
+        frac &= 0xffff;
+    }
+
+    if (sfxcacheused + newlen + 40 > (unsigned long)snd_SfxCache << 10)
+    {
+        return 0;
+    }
+    sfxcacheused += newlen + 40;
+
+    // Keep the DMX layout: header, 16 bytes of padding on both sides
+    Z_Malloc(newlen + 40, PU_SOUND, vdata);
+    dest = (unsigned char *)*vdata;
+
+    dest[0] = 3;
+    dest[1] = 0;
+    dest[2] = mixrate & 0xff;
+    dest[3] = mixrate >> 8;
+    dest[4] = (newlen + 32) & 0xff;
+    dest[5] = ((newlen + 32) >> 8) & 0xff;
+    dest[6] = ((newlen + 32) >> 16) & 0xff;
+    dest[7] = (newlen + 32) >> 24;
+    SetBytes(dest + 8, 0x80, 16);
+    SetBytes(dest + 24 + newlen, 0x80, 16);
+
+    data += 24;
+    dest += 24;
+    for (i = 0, frac = 0; newlen; newlen--)
+    {
+        *dest++ = data[i];
+        frac += step;
+        i += frac >> 16;
+        frac &= 0xffff;
+    }
+
+    // The lump isn't needed any more
+    Z_ChangeTag(data - 24, PU_CACHE);
+
+    return 1;
+}
+
+//
+// SFX_LockPatch
+// Keeps a converted sound for the level again. Returns 0 if it was
+// purged or doesn't fit in the budget any more, *vdata is NULL then.
+//
+int SFX_LockPatch(void **vdata)
+{
+    unsigned char *data = (unsigned char *)*vdata;
+    memblock_t *block;
+    unsigned long size;
+
+    if (!data)
+    {
+        return 0;
+    }
+
+    block = (memblock_t *)(data - sizeof(memblock_t));
+    if (block->tag != PU_CACHE)
+    {
+        return 1;
+    }
+
+    size = SFX_PatchSize(data);
+    if (sfxcacheused + size > (unsigned long)snd_SfxCache << 10)
+    {
+        Z_Free(data);
+        return 0;
+    }
+    sfxcacheused += size;
+
+    Z_ChangeTag(data, PU_SOUND);
+
+    return 1;
+}
+
+//
+// SFX_ReleasePatch
+// A converted sound may be purged until it plays again
+//
+void SFX_ReleasePatch(void *vdata)
+{
+    unsigned char *data = (unsigned char *)vdata;
+    memblock_t *block = (memblock_t *)(data - sizeof(memblock_t));
+
+    if (block->tag == PU_CACHE)
+    {
+        return;
+    }
+
+    sfxcacheused -= SFX_PatchSize(data);
+
+    Z_ChangeTag(data, PU_CACHE);
+}
+
+int SFX_PlayPatch(void *vdata, int sep, int vol, int priority)
 {
     const unsigned short divisors[] = {
         0, 6818, 6628, 6449, 6279, 6087, 5906, 5736, 5575, 5423, 5279, 5120, 4971, 4830, 4697, 4554, 4435, 4307, 4186, 4058, 3950,3836,
@@ -182,7 +333,7 @@ int SFX_PlayPatch(void *vdata, int sep, int vol)
         }
         len -= 32;
 
-        return MV_PlayRaw(data + 24, len, rate, vol * 2, Div63((254 - sep) * vol), Div63((sep)*vol), 100);
+        return MV_PlayRaw(data + 24, len, rate, vol * 2, Div63((254 - sep) * vol), Div63((sep)*vol), priority);
     }
 
     return -1;
@@ -474,6 +625,9 @@ void ASS_Init(int rate, int mdev, int sdev)
 
         if (reverseStereo)
             MV_ReverseStereo();
+
+        if (accumMix)
+            MV_SetAccumulate(TRUE);
     }
 }
 
@@ -483,10 +637,6 @@ void ASS_DeInit(void)
     FX_Shutdown();
     PCFX_Shutdown();
     remove("ULTRAMID.INI");
-    if (mid_data)
-    {
-        free(mid_data);
-    }
 }
 
 int ENS_Detect(void)
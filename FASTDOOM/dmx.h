@@ -23,10 +23,13 @@ int GUS_Init(void);
 void GUS_Shutdown(void);
 
 void TSM_Remove(void);
-int MUS_RegisterSong(void *data);
+int MUS_RegisterSong(void *data, int lumpnum);
 int MUS_ChainSong(int handle, int next);
 void MUS_PlaySong(int handle, int volume);
-int SFX_PlayPatch(void *vdata, int sep, int vol);
+int SFX_CachePatch(void **vdata);
+int SFX_LockPatch(void **vdata);
+void SFX_ReleasePatch(void *vdata);
+int SFX_PlayPatch(void *vdata, int sep, int vol, int priority);
 void SFX_StopPatch(int handle);
 int SFX_Playing(int handle);
 void SFX_SetOrigin(int handle, int sep, int vol);
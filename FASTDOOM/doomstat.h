@@ -54,7 +54,12 @@ extern boolean nearSprites;
 extern boolean monoSound;
 extern boolean noMelt;
 
+#if defined(USE_BACKBUFFER)
+extern boolean overdrawRender;
+#endif
+
 extern boolean reverseStereo;
+extern boolean accumMix;
 
 extern boolean forceHighDetail;
 extern boolean forceLowDetail;
@@ -252,6 +257,20 @@ extern int mouseSensitivity;
 //?
 // debug flag to cancel adaptiveness
 extern boolean singletics;
+// -timedemo -nodraw, only the game simulation runs
+extern boolean nodrawers;
+// Per tic game state checksum during demo playback
+extern boolean checksumparm;
+// Keep the last savegame as an in-memory snapshot
+extern boolean memsaveparm;
+// Add the sector visibility table to the reject matrix
+extern boolean visparm;
+
+// Cull the BSP with the sector visibility table
+extern boolean pvsparm;
+// Timed demos simulate the first warptic tics without rendering
+extern int warptic;
+extern boolean warping;
 extern boolean benchmark;
 extern boolean benchmark_finished;
 extern boolean benchmark_commandline;
@@ -264,6 +283,17 @@ extern unsigned int benchmark_number;
 extern boolean benchmark_advanced;
 extern char benchmark_file[20];
 extern int benchmark_total;
+
+// Demos of a command line benchmark ("-benchmark file demo1,demo2 ...")
+#define BENCHMARK_MAXDEMOS 8
+extern char benchmark_demos[BENCHMARK_MAXDEMOS][13];
+extern unsigned int benchmark_demos_num;
+
+// Every benchmark run is repeated, warm-up runs are discarded
+#define BENCHMARK_MAXREPEAT 64
+extern int benchmark_repeat;
+extern int benchmark_warmup;
+extern int benchmark_repetition;
 extern char **benchmark_files;
 extern unsigned int benchmark_files_num;
 extern unsigned int benchmark_total_tics;
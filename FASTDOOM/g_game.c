@@ -19,6 +19,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 
 #include "i_random.h"
 
@@ -67,6 +68,8 @@
 
 #include "i_log.h"
 
+#include "i_debug.h"
+
 #define SAVEGAMESIZE 0x2c000
 #define SAVESTRINGSIZE 24
 #define DEMOMARKER 0x80
@@ -116,6 +119,7 @@ byte *demobuffer;
 byte *demo_p;
 byte *demoend;
 byte singledemo = 0; // quit after playing a demo from cmdline
+char *defdemoname;
 
 wbstartstruct_t wminfo; // parms for world map / intermission
 
@@ -437,6 +441,109 @@ void G_DoReborn(int playernum)
     gameaction = ga_loadlevel;
 }
 
+//
+// Demo warp (-warptic N). The first N tics of a timed demo are simulated
+// without rendering and timing starts after them. The state at tic N is
+// kept as a snapshot, the next run of the same demo (-repeat, benchmark
+// files) restores it instead of simulating again. Snapshots only apply
+// to the level load they were taken on, so this works while the level
+// of tic N is still loaded: runs that change level after tic N, or any
+// other level load in between, simulate again.
+//
+int demotic;
+snapshot_t *warpsnapshot;
+char warpdemo[13];
+int warpoffset;
+
+void G_FinishWarp(void)
+{
+    warping = false;
+
+    // Timing starts now, without a screen wipe
+    starttime = ticcount;
+    benchmark_starttic = gametic;
+    wipegamestate = gamestate;
+}
+
+//
+// Game state checksum, one line per tic on CHECKSUM.CSV while a demo
+// plays with -checksum. Builds that keep demo compatibility write the
+// same file for the same demo.
+//
+#define CHECKSUM_FILE "CHECKSUM.CSV"
+
+// FNV-1a, one dword at a time
+#define CHECKSUM_BASIS 2166136261u
+#define CHECKSUM_ADD(value) hash = (hash ^ (unsigned int)(value)) * 16777619u
+
+FILE *checksumfile;
+unsigned int checksumtic;
+
+//
+// G_MobjsChecksum
+// Sum of the hashes of every mobj in the list. Each mobj is hashed
+// on its own so the result does not depend on the thinker order, or
+// on which list a mobj is kept in.
+//
+unsigned int G_MobjsChecksum(thinker_t *cap)
+{
+    thinker_t *th;
+    unsigned int sum = 0;
+
+    for (th = cap->next; th != cap; th = th->next)
+    {
+        mobj_t *mo;
+        unsigned int hash = CHECKSUM_BASIS;
+
+        if (th->function.acp1 != (actionf_p1)P_MobjThinker && th->function.acp1 != (actionf_p1)P_MobjBrainlessThinker && th->function.acp1 != (actionf_p1)P_MobjTicklessThinker)
+            continue;
+
+        mo = (mobj_t *)th;
+
+        CHECKSUM_ADD(mo->type);
+        CHECKSUM_ADD(mo->x);
+        CHECKSUM_ADD(mo->y);
+        CHECKSUM_ADD(mo->z);
+        CHECKSUM_ADD(mo->momx);
+        CHECKSUM_ADD(mo->momy);
+        CHECKSUM_ADD(mo->momz);
+        CHECKSUM_ADD(mo->angle);
+        CHECKSUM_ADD(mo->state - states);
+        CHECKSUM_ADD(mo->tics);
+        CHECKSUM_ADD(mo->flags);
+        CHECKSUM_ADD(mo->health);
+
+        sum += hash;
+    }
+
+    return sum;
+}
+
+unsigned int G_GameStateChecksum(void)
+{
+    unsigned int hash = CHECKSUM_BASIS;
+    int i;
+
+    CHECKSUM_ADD(prndindex);
+    CHECKSUM_ADD(leveltime);
+    CHECKSUM_ADD(G_MobjsChecksum(&thinkercap) + G_MobjsChecksum(&ticklesscap));
+
+    for (i = 0; i < numsectors; i++)
+    {
+        CHECKSUM_ADD(sectors[i].floorheight);
+        CHECKSUM_ADD(sectors[i].ceilingheight);
+        CHECKSUM_ADD(sectors[i].lightlevel);
+        CHECKSUM_ADD(sectors[i].special);
+    }
+
+    CHECKSUM_ADD(players.health);
+    CHECKSUM_ADD(players.armorpoints);
+    CHECKSUM_ADD(players.readyweapon);
+    CHECKSUM_ADD(players.viewz);
+
+    return hash;
+}
+
 //
 // G_Ticker
 // Make ticcmd_ts for the players.
@@ -447,6 +554,8 @@ void G_Ticker(void)
     int buf;
     ticcmd_t *cmd;
 
+    I_Trace(TRACE_TIC_BEGIN, gametic, 0);
+
     // do player reborns if needed
     if (players.playerstate == PST_REBORN)
         G_DoReborn(0);
@@ -543,6 +652,29 @@ void G_Ticker(void)
         D_PageTicker();
         break;
     }
+
+    if (warping && demotic >= warptic)
+    {
+        if (gamestate == GS_LEVEL)
+        {
+            if (warpsnapshot)
+                P_FreeSnapshot(warpsnapshot);
+
+            warpsnapshot = P_TakeSnapshot();
+            warpoffset = demo_p - demobuffer;
+            sprintf(warpdemo, "%s", defdemoname);
+        }
+
+        G_FinishWarp();
+    }
+
+    if (checksumfile && demoplayback)
+    {
+        fprintf(checksumfile, "%u,%08x\n", checksumtic, G_GameStateChecksum());
+        checksumtic++;
+    }
+
+    I_Trace(TRACE_TIC_END, gametic, 0);
 }
 
 //
@@ -797,6 +929,55 @@ extern byte setsizeneeded;
 
 char savename[256];
 
+//
+// With -memsave the last savegame is also kept as a snapshot, loading it
+// again before the level is reloaded restores it in place without
+// P_SetupLevel
+//
+snapshot_t *savesnapshot;
+char savesnapshotname[256];
+
+//
+// G_ResumeLevel
+// What G_InitNew resets besides the level, for snapshots restored
+// into the loaded level
+//
+void G_ResumeLevel(void)
+{
+    if (paused)
+    {
+        paused = 0;
+        S_ResumeMusic();
+    }
+
+    // Level music, a demo run can end on the intermission
+    S_Start();
+
+#if defined(MODE_Y) || defined(USE_BACKBUFFER) || defined(MODE_VBE2_DIRECT)
+    automapactive = 0;
+#endif
+    viewactive = 1;
+    gamestate = GS_LEVEL;
+    gameaction = ga_nothing;
+
+    // clear cmd building stuff
+    memset(gamekeydown, 0, sizeof(gamekeydown));
+    mousex = 0;
+    sendpause = sendsave = 0;
+    memset(mousebuttons, 0, sizeof(mousebuttons));
+}
+
+void G_LoadGameDone(void)
+{
+    if (setsizeneeded)
+        R_ExecuteSetViewSize();
+
+// draw the pattern into the back screen
+#if defined(MODE_Y) || defined(USE_BACKBUFFER) || defined(MODE_VBE2_DIRECT)
+    R_FillBackScreen();
+#endif
+}
+
 void G_LoadGame(char *name)
 {
     strcpy(savename, name);
@@ -815,6 +996,13 @@ void G_DoLoadGame(void)
 
     gameaction = ga_nothing;
 
+    if (savesnapshot && gamestate == GS_LEVEL && !strcmp(savename, savesnapshotname) && P_RestoreSnapshot(savesnapshot))
+    {
+        G_ResumeLevel();
+        G_LoadGameDone();
+        return;
+    }
+
     length = M_ReadFile(savename, &savebuffer);
     save_p = savebuffer + SAVESTRINGSIZE;
 
@@ -854,13 +1042,7 @@ void G_DoLoadGame(void)
     // done
     Z_Free(savebuffer);
 
-    if (setsizeneeded)
-        R_ExecuteSetViewSize();
-
-// draw the pattern into the back screen
-#if defined(MODE_Y) || defined(USE_BACKBUFFER) || defined(MODE_VBE2_DIRECT)
-    R_FillBackScreen();
-#endif
+    G_LoadGameDone();
 }
 
 //
@@ -926,10 +1108,19 @@ void G_DoSaveGame(void)
     gameaction = ga_nothing;
     savedescription[0] = 0;
 
-    players.message = GGSAVED;
-
     Z_Free(savebuffer);
 
+    if (memsaveparm && gamestate == GS_LEVEL)
+    {
+        if (savesnapshot)
+            P_FreeSnapshot(savesnapshot);
+
+        savesnapshot = P_TakeSnapshot();
+        strcpy(savesnapshotname, name);
+    }
+
+    players.message = GGSAVED;
+
 // draw the pattern into the back screen
 #if defined(MODE_Y) || defined(USE_BACKBUFFER) || defined(MODE_VBE2_DIRECT)
     R_FillBackScreen();
@@ -1092,6 +1283,7 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd)
     cmd->sidemove = ((signed char)*demo_p++) << 11;
     cmd->angleturn = ((unsigned char)*demo_p++) << (8+16);
     cmd->buttons = (unsigned char)*demo_p++;
+    demotic++;
 }
 
 void G_WriteDemoTiccmd(ticcmd_t *cmd)
@@ -1160,8 +1352,6 @@ void G_BeginRecording(void)
 // G_PlayDemo
 //
 
-char *defdemoname;
-
 void G_DeferedPlayDemo(char *name)
 {
     if (!disableDemo)
@@ -1173,7 +1363,7 @@ void G_DeferedPlayDemo(char *name)
 
 unsigned int G_GetDemoTicks(char *demofile)
 {
-    unsigned int count;
+    unsigned int count = 0;
 
     demobuffer = demo_p = W_CacheLumpName(demofile, PU_STATIC);
     
@@ -1233,11 +1423,39 @@ void G_DoPlayDemo(void)
     *demo_p++;
     *demo_p++;
 
-    // don't spend a lot of time in loadlevel
-    G_InitNew(skill, episode, map);
+    // The level the warp snapshot was taken on is still loaded when the
+    // last run of this demo stayed on it, continue from there
+    if (warptic > 0 && timingdemo && warpsnapshot && !strcmp(warpdemo, defdemoname) && P_RestoreSnapshot(warpsnapshot))
+    {
+        G_ResumeLevel();
+        demo_p = demobuffer + warpoffset;
+        demotic = warptic;
+        G_FinishWarp();
+    }
+    else
+    {
+        // don't spend a lot of time in loadlevel
+        G_InitNew(skill, episode, map);
+        demotic = 0;
+        warping = warptic > 0 && timingdemo;
+    }
 
     usergame = 0;
     demoplayback = 1;
+
+    if (checksumparm)
+    {
+        if (checksumfile)
+            fclose(checksumfile);
+
+        checksumfile = fopen(CHECKSUM_FILE, "w");
+
+        // Rows keep the demo tic after a warp, so they line up with a full run
+        checksumtic = demotic;
+
+        if (checksumfile)
+            fprintf(checksumfile, "tic,checksum\n");
+    }
 }
 
 //
@@ -1245,6 +1463,10 @@ void G_DoPlayDemo(void)
 //
 void G_TimeDemo(char *name)
 {
+#if (PROFILER_ENABLED == 1)
+    I_ProfilerReset();
+#endif
+
     timingdemo = 1;
     singletics = true;
 
@@ -1265,23 +1487,164 @@ void G_TimeDemo(char *name)
 #define CSV_COLUMN ","
 #define CSV_DECIMAL "."
 #define CSV_FILE "BENCH.CSV"
+#define CSV_REPEAT_FILE "BENCHREP.CSV"
+
+#define BENCHMARK_REPEATING (benchmark_repeat > 1 || benchmark_warmup > 0)
+
+// Repeated runs have extra columns, keep them out of BENCH.CSV so
+// every file has a single header
+#define CSV_RESULT_FILE (BENCHMARK_REPEATING ? CSV_REPEAT_FILE : CSV_FILE)
+
+//
+// Statistics of repeated benchmark runs, in FPS * 1000 like resultfps.
+// There is no FPU code in the executable, everything is integer math.
+//
+typedef struct
+{
+    unsigned int median;
+    unsigned int mean;
+    unsigned int stddev;
+    unsigned int ci95; // Half width of the 95% confidence interval
+} benchstats_t;
+
+unsigned int repeatgametics[BENCHMARK_MAXREPEAT];
+unsigned int repeatrealtics[BENCHMARK_MAXREPEAT];
+unsigned int repeatfps[BENCHMARK_MAXREPEAT];
+unsigned int repeatonepercentlow[BENCHMARK_MAXREPEAT];
+unsigned int repeatdotonepercentlow[BENCHMARK_MAXREPEAT];
+
+benchstats_t statsgametics;
+benchstats_t statsrealtics;
+benchstats_t statsfps;
+benchstats_t statsonepercentlow;
+benchstats_t statsdotonepercentlow;
+
+// Student's t (two sided 95%) * 1000 for 1 to 30 degrees of freedom
+const unsigned short studentt95[30] = {
+    12706, 4303, 3182, 2776, 2571, 2447, 2365, 2306, 2262, 2228,
+    2201, 2179, 2160, 2145, 2131, 2120, 2110, 2101, 2093, 2086,
+    2080, 2074, 2069, 2064, 2060, 2056, 2052, 2048, 2045, 2042};
+
+unsigned int G_SquareRoot(unsigned int value)
+{
+    unsigned int result = 0;
+    unsigned int bit = 1 << 30;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return result;
+}
+
+void G_CalculateStats(unsigned int *values, int count, benchstats_t *stats)
+{
+    unsigned int sorted[BENCHMARK_MAXREPEAT];
+    unsigned int sum = 0;
+    unsigned int variance = 0;
+    unsigned int t;
+    int i, j;
+
+    // Insertion sort, there are only a few runs
+    for (i = 0; i < count; i++)
+    {
+        unsigned int value = values[i];
+
+        for (j = i; j > 0 && sorted[j - 1] > value; j--)
+            sorted[j] = sorted[j - 1];
+
+        sorted[j] = value;
+        sum += value;
+    }
+
+    if (count & 1)
+        stats->median = sorted[count / 2];
+    else
+        stats->median = (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+
+    stats->mean = sum / count;
+
+    if (count < 2)
+    {
+        stats->stddev = 0;
+        stats->ci95 = 0;
+        return;
+    }
+
+    // Sample variance, saturated instead of overflowing
+    for (i = 0; i < count; i++)
+    {
+        int diff = (int)values[i] - (int)stats->mean;
+        unsigned int term;
+
+        if (diff < 0)
+            diff = -diff;
+        if (diff > 65535)
+            diff = 65535;
+
+        term = ((unsigned int)diff * (unsigned int)diff) / (count - 1);
+
+        if (variance + term < variance)
+            variance = UINT_MAX;
+        else
+            variance += term;
+    }
+
+    stats->stddev = G_SquareRoot(variance);
+
+    t = count - 1 <= 30 ? studentt95[count - 2] : 1960;
+
+    // t * stddev / sqrt(count), with t scaled by 1000
+    stats->ci95 = (t * stats->stddev) / G_SquareRoot(count * 1000000);
+}
 
 void G_CreateCSV(void)
 {
     FILE *fptr;
-    fptr = fopen(CSV_FILE, "r");
+    fptr = fopen(CSV_RESULT_FILE, "r");
     if (fptr == NULL) // if file does not exist, create it
     {
-        fptr = fopen(CSV_FILE, "w+");
-        fprintf(fptr, "executable" CSV_COLUMN "arch" CSV_COLUMN "detail" CSV_COLUMN "size" CSV_COLUMN "visplanes" CSV_COLUMN "sky" CSV_COLUMN "objects" CSV_COLUMN "transparent_columns" CSV_COLUMN "iwad" CSV_COLUMN "demo" CSV_COLUMN "gametics" CSV_COLUMN "realtics" CSV_COLUMN "fps" CSV_COLUMN "onepercentlow" CSV_COLUMN "dotonepercentlow\n");
+        fptr = fopen(CSV_RESULT_FILE, "w+");
+        fprintf(fptr, "executable" CSV_COLUMN "arch" CSV_COLUMN "detail" CSV_COLUMN "size" CSV_COLUMN "visplanes" CSV_COLUMN "sky" CSV_COLUMN "objects" CSV_COLUMN "transparent_columns" CSV_COLUMN "iwad" CSV_COLUMN "demo" CSV_COLUMN "gametics" CSV_COLUMN "realtics" CSV_COLUMN "fps" CSV_COLUMN "onepercentlow" CSV_COLUMN "dotonepercentlow");
+
+        if (BENCHMARK_REPEATING)
+        {
+            fprintf(fptr, CSV_COLUMN "runs" CSV_COLUMN "warmup");
+            fprintf(fptr, CSV_COLUMN "fps_median" CSV_COLUMN "fps_mean" CSV_COLUMN "fps_stddev" CSV_COLUMN "fps_ci95");
+            fprintf(fptr, CSV_COLUMN "onepercentlow_median" CSV_COLUMN "onepercentlow_mean" CSV_COLUMN "onepercentlow_stddev" CSV_COLUMN "onepercentlow_ci95");
+            fprintf(fptr, CSV_COLUMN "dotonepercentlow_median" CSV_COLUMN "dotonepercentlow_mean" CSV_COLUMN "dotonepercentlow_stddev" CSV_COLUMN "dotonepercentlow_ci95");
+        }
+
+        fprintf(fptr, "\n");
         fclose(fptr);
     }
     fclose(fptr);
 }
 
+void G_SaveCSVStats(FILE *logFile, benchstats_t *stats)
+{
+    fprintf(logFile, CSV_COLUMN "%u" CSV_DECIMAL "%.3u", stats->median / 1000, stats->median % 1000);
+    fprintf(logFile, CSV_COLUMN "%u" CSV_DECIMAL "%.3u", stats->mean / 1000, stats->mean % 1000);
+    fprintf(logFile, CSV_COLUMN "%u" CSV_DECIMAL "%.3u", stats->stddev / 1000, stats->stddev % 1000);
+    fprintf(logFile, CSV_COLUMN "%u" CSV_DECIMAL "%.3u", stats->ci95 / 1000, stats->ci95 % 1000);
+}
+
 void G_SaveCSVResult(unsigned int gametics, unsigned int realtics, unsigned int resultfps, unsigned int onepercentlow, unsigned int dotonepercentlow)
 {
-    FILE *logFile = fopen(CSV_FILE, "a");
+    FILE *logFile = fopen(CSV_RESULT_FILE, "a");
     if (logFile)
     {
         // Executable
@@ -1407,7 +1770,18 @@ void G_SaveCSVResult(unsigned int gametics, unsigned int realtics, unsigned int
         fprintf(logFile, "%u" CSV_DECIMAL "%.3u" CSV_COLUMN, onepercentlow / 1000, onepercentlow % 1000);
         
         // 0.1% low FPS
-        fprintf(logFile, "%u" CSV_DECIMAL "%.3u\n", dotonepercentlow / 1000, dotonepercentlow % 1000);
+        fprintf(logFile, "%u" CSV_DECIMAL "%.3u", dotonepercentlow / 1000, dotonepercentlow % 1000);
+
+        // Repeated runs
+        if (BENCHMARK_REPEATING)
+        {
+            fprintf(logFile, CSV_COLUMN "%i" CSV_COLUMN "%i", benchmark_repeat, benchmark_warmup);
+            G_SaveCSVStats(logFile, &statsfps);
+            G_SaveCSVStats(logFile, &statsonepercentlow);
+            G_SaveCSVStats(logFile, &statsdotonepercentlow);
+        }
+
+        fprintf(logFile, "\n");
 
         fclose(logFile);
     }
@@ -1422,7 +1796,11 @@ void G_CreateFrametime(void)
     if (fptr == NULL) // if file does not exist, create it
     {
         fptr = fopen(FRAMETIME_FILE, "w+");
-        fprintf(fptr, "frame" CSV_COLUMN "milliseconds\n");
+#if (RENDERSTATS_ENABLED == 1)
+        fprintf(fptr, "frame" CSV_COLUMN "microseconds" CSV_COLUMN "segs" CSV_COLUMN "drawsegs" CSV_COLUMN "visplanes" CSV_COLUMN "spans" CSV_COLUMN "columns" CSV_COLUMN "pixels" CSV_COLUMN "vissprites" CSV_COLUMN "maskedcolumns\n");
+#else
+        fprintf(fptr, "frame" CSV_COLUMN "microseconds\n");
+#endif
         fclose(fptr);
     }
     fclose(fptr);
@@ -1439,7 +1817,15 @@ void G_SaveFrametimeResult(unsigned int start, unsigned int count)
 
         for (i = start; i < count; i++)
         {
+#if (RENDERSTATS_ENABLED == 1)
+            renderstats_t *stats = &framestats[i];
+
+            fprintf(logFile, "%u" CSV_COLUMN "%u" CSV_COLUMN, counter, frametime[i]);
+            fprintf(logFile, "%u" CSV_COLUMN "%u" CSV_COLUMN "%u" CSV_COLUMN, stats->segs, stats->drawsegs, stats->visplanes);
+            fprintf(logFile, "%u" CSV_COLUMN "%u" CSV_COLUMN "%u" CSV_COLUMN "%u" CSV_COLUMN "%u\n", stats->spans, stats->columns, stats->pixels, stats->vissprites, stats->maskedcolumns);
+#else
             fprintf(logFile, "%u" CSV_COLUMN "%u\n", counter, frametime[i]);
+#endif
             counter++;
         }
 
@@ -1447,12 +1833,60 @@ void G_SaveFrametimeResult(unsigned int start, unsigned int count)
     }
 }
 
+//
+// G_SaveBenchmarkResult
+// Repeated runs only save a row after the last one, the tics and fps
+// columns then hold the median of the measured runs
+//
+void G_SaveBenchmarkResult(unsigned int gametics, unsigned int realtics, unsigned int resultfps, unsigned int onepercentlow, unsigned int dotonepercentlow)
+{
+    int run;
+
+    if (!BENCHMARK_REPEATING)
+    {
+        G_SaveCSVResult(gametics, realtics, resultfps, onepercentlow, dotonepercentlow);
+        return;
+    }
+
+    // Warm-up runs only fill the disk cache
+    if (benchmark_repetition < benchmark_warmup)
+        return;
+
+    run = benchmark_repetition - benchmark_warmup;
+
+    repeatgametics[run] = gametics;
+    repeatrealtics[run] = realtics;
+    repeatfps[run] = resultfps;
+    repeatonepercentlow[run] = onepercentlow;
+    repeatdotonepercentlow[run] = dotonepercentlow;
+
+    if (run + 1 < benchmark_repeat)
+        return;
+
+    G_CalculateStats(repeatgametics, benchmark_repeat, &statsgametics);
+    G_CalculateStats(repeatrealtics, benchmark_repeat, &statsrealtics);
+    G_CalculateStats(repeatfps, benchmark_repeat, &statsfps);
+    G_CalculateStats(repeatonepercentlow, benchmark_repeat, &statsonepercentlow);
+    G_CalculateStats(repeatdotonepercentlow, benchmark_repeat, &statsdotonepercentlow);
+
+    G_SaveCSVResult(statsgametics.median, statsrealtics.median, statsfps.median, statsonepercentlow.median, statsdotonepercentlow.median);
+}
+
 void G_CheckDemoStatus(void)
 {
     unsigned int realtics;
     unsigned int resultfps;
     unsigned int gametics;
 
+    if (checksumfile)
+    {
+        fclose(checksumfile);
+        checksumfile = NULL;
+    }
+
+    // Demo ended before reaching -warptic
+    warping = false;
+
     if (timingdemo)
     {
         if (benchmark)
@@ -1466,9 +1900,10 @@ void G_CheckDemoStatus(void)
         }
         else
         {
-            gametics = gametic;
+            // benchmark_starttic is only set after -warptic
+            gametics = gametic - benchmark_starttic;
             realtics = ticcount - starttime;
-            resultfps = (35 * 1000 * (unsigned int)gametic) / (unsigned int)realtics;
+            resultfps = (35 * 1000 * (unsigned int)gametics) / (unsigned int)realtics;
         }
 
         if (csv)
@@ -1479,11 +1914,11 @@ void G_CheckDemoStatus(void)
             {
                 unsigned int i, j;
                 unsigned int temp;
-                unsigned int onepercentlow_ms = 0;
+                unsigned int onepercentlow_us = 0;
                 unsigned int onepercentlow_fps = 0;
                 unsigned int onepercentlow_num = 0;
 
-                unsigned int dotonepercentlow_ms = 0;
+                unsigned int dotonepercentlow_us = 0;
                 unsigned int dotonepercentlow_fps = 0;
                 unsigned int dotonepercentlow_num = 0;
 
@@ -1517,12 +1952,11 @@ void G_CheckDemoStatus(void)
 
                 for (i = fix_start; i < onepercentlow_num + fix_start; i++) // Omit first frame (load data)
                 {
-                    onepercentlow_ms += frametime[i];
+                    onepercentlow_us += frametime[i];
                 }
 
-                onepercentlow_ms *= 1000;
-                onepercentlow_ms /= onepercentlow_num; // Average ms 1% low
-                onepercentlow_fps = 1000000000u / onepercentlow_ms;
+                onepercentlow_us /= onepercentlow_num; // Average us 1% low
+                onepercentlow_fps = 1000000000u / onepercentlow_us;
 
                 // Calculate 0.1% low frametimes
                 dotonepercentlow_num = frametime_position / 1000; // 0.1% Low
@@ -1532,14 +1966,13 @@ void G_CheckDemoStatus(void)
 
                 for (i = fix_start; i < dotonepercentlow_num + fix_start; i++) // Omit first frame (load data)
                 {
-                    dotonepercentlow_ms += frametime[i];
+                    dotonepercentlow_us += frametime[i];
                 }
 
-                dotonepercentlow_ms *= 1000;
-                dotonepercentlow_ms /= dotonepercentlow_num; // Average ms 0.1% low
-                dotonepercentlow_fps = 1000000000u / dotonepercentlow_ms;
+                dotonepercentlow_us /= dotonepercentlow_num; // Average us 0.1% low
+                dotonepercentlow_fps = 1000000000u / dotonepercentlow_us;
 
-                G_SaveCSVResult(gametics, realtics, resultfps, onepercentlow_fps, dotonepercentlow_fps);
+                G_SaveBenchmarkResult(gametics, realtics, resultfps, onepercentlow_fps, dotonepercentlow_fps);
 
                 // Cleanup frametimes
                 frametime_position = 0;
@@ -1548,13 +1981,21 @@ void G_CheckDemoStatus(void)
                 {
                     frametime[i] = 0;
                 }
+
+#if (RENDERSTATS_ENABLED == 1)
+                SetDWords(framestats, 0, (benchmark_total_tics * sizeof(renderstats_t)) / 4);
+#endif
             }
             else
             {
-                G_SaveCSVResult(gametics, realtics, resultfps, 0, 0);
+                G_SaveBenchmarkResult(gametics, realtics, resultfps, 0, 0);
             }
         }
 
+#if (PROFILER_ENABLED == 1)
+        I_ProfilerDump();
+#endif
+
         if (benchmark)
         {
             timingdemo = 0;
@@ -1562,6 +2003,16 @@ void G_CheckDemoStatus(void)
 
             benchmark_finished = true;
         }
+        else if (nodrawers)
+        {
+            // Without rendering every frame is a tic
+            static char report[1024];
+
+            P_ThinkerReport(report);
+            P_SightReport(report + strlen(report));
+            I_MusicReport(report + strlen(report), realtics);
+            I_Error("Timed %u gametics in %u realtics. Tics/s: %u.%.3u\n\n%s", gametics, realtics, resultfps / 1000, resultfps % 1000, report);
+        }
         else
         {
             I_Error("Timed %u gametics in %u realtics. FPS: %u.%.3u", gametics, realtics, resultfps / 1000, resultfps % 1000);
@@ -10,6 +10,7 @@
 #include "i_ibm.h"
 #include "i_system.h"
 #include "i_debug.h"
+#include "ns_dpmi.h"
 
 #define COLOURS 0xFF
 #define COLS 80
@@ -17,7 +18,7 @@
 
 
 
-#if (DEBUG_ENABLED == 1)
+#if (DEBUG_ENABLED == 1) || (PROFILER_ENABLED == 1)
 
 int debug_to_screen = 0;
 
@@ -349,6 +350,7 @@ static void ReadMapFile(debugmodule_t **modules, int *num_modules, debugsymbol_t
             current_symbol->addr = addr;
             current_symbol->name = name;
             current_symbol->module = current_module;
+            current_symbol->is_data = line[3] == '2';
             if (_num_symbols > MAX_SYMBOLS) {
                 I_Printf("Too many symbols, symtable incomplete, boost "
                          "MAX_SYMBOLS.\n");
@@ -494,7 +496,7 @@ void I_Backtrace(const char *msg, ...) {
         // THe return pointer is the second thing on the stack frame
         int *retptr = frame + 1;
         // Does the return pointer make seense?
-        if (*retptr > text_start && *retptr < text_end) {
+        if (*retptr >= text_start && *retptr < text_end) {
           // Record the frame if we have space
           if (num_backtrace >= MAX_BACKTRACE_FRAMES) {
               I_Printf("Notice: backtrace is truncated\n");
@@ -555,4 +557,171 @@ void I_Backtrace(const char *msg, ...) {
 #endif
 }
 
-#endif // DEBUG_ENABLED
+#if (PROFILER_ENABLED == 1)
+
+//
+// Statistical profiler
+// The timer ISR stores the interrupted EIP on a preallocated ring,
+// samples are resolved against the map file only when dumped. Sampling
+// stops at the first dump, so a timedemo profile isn't overwritten by
+// the shutdown one, I_ProfilerReset starts it again.
+//
+
+#define PROFILER_SAMPLES 65536
+#define PROFILER_FILE "PROFILE.TXT"
+
+static unsigned int *profiler_samples = NULL;
+static volatile unsigned int profiler_head = 0;
+static volatile byte profiler_enabled = 0;
+static byte profiler_dumped = 0;
+
+void I_ProfilerInit(void) {
+    profiler_samples = malloc(PROFILER_SAMPLES * sizeof(unsigned int));
+    if (profiler_samples == NULL) {
+        I_Printf("Failed to allocate profiler samples, profiler disabled\n");
+        return;
+    }
+    DPMI_LockMemory(profiler_samples, PROFILER_SAMPLES * sizeof(unsigned int));
+    profiler_head = 0;
+    profiler_enabled = 1;
+}
+
+// Called from the timer ISR, keep it short
+void I_ProfilerSample(unsigned int eip) {
+    if (profiler_enabled) {
+        profiler_samples[profiler_head & (PROFILER_SAMPLES - 1)] = eip;
+        profiler_head++;
+    }
+}
+
+void I_ProfilerReset(void) {
+    profiler_enabled = 0;
+    profiler_head = 0;
+    profiler_dumped = 0;
+    profiler_enabled = profiler_samples != NULL;
+}
+
+static int CompareSamples(const void *a, const void *b) {
+    unsigned int x = *(const unsigned int *)a;
+    unsigned int y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    debugsymbol_t *symbol;
+    unsigned int count;
+} profilerentry_t;
+
+static int CompareEntries(const void *a, const void *b) {
+    unsigned int x = ((const profilerentry_t *)a)->count;
+    unsigned int y = ((const profilerentry_t *)b)->count;
+    return (x < y) - (x > y);
+}
+
+// Resolve the samples taken so far and write a flat per-function histogram
+void I_ProfilerDump(void) {
+    extern char ___Argc;
+    unsigned int text_start = TEXT_SECTION_START;
+    unsigned int text_end = (unsigned int)&___Argc;
+    unsigned int num_samples;
+    unsigned int *sorted;
+    profilerentry_t *entries;
+    int num_entries = 0;
+    unsigned int outside = 0;
+    unsigned int unknown = 0;
+    unsigned int i;
+    int sym;
+    FILE *f;
+
+    if (profiler_dumped) {
+        return;
+    }
+
+    // The ring isn't written while it is read
+    profiler_enabled = 0;
+    profiler_dumped = 1;
+    num_samples = profiler_head;
+
+    if (profiler_samples == NULL || num_samples == 0) {
+        return;
+    }
+    if (num_samples > PROFILER_SAMPLES) {
+        num_samples = PROFILER_SAMPLES;
+    }
+    if (!modules) {
+        ReadMapFile(&modules, &num_modules, &symbols, &num_symbols);
+    }
+
+    sorted = malloc(num_samples * sizeof(unsigned int));
+    entries = malloc((num_symbols + 1) * sizeof(profilerentry_t));
+    if (sorted == NULL || entries == NULL) {
+        I_Printf("Failed to allocate memory for profiler dump\n");
+        free(sorted);
+        free(entries);
+        return;
+    }
+
+    // Keep text offsets only, anything else was sampled in real mode,
+    // BIOS or the extender
+    for (i = 0, sym = 0; i < num_samples; i++) {
+        unsigned int eip = profiler_samples[i];
+        if (eip >= text_start && eip < text_end) {
+            sorted[sym++] = eip - text_start;
+        } else {
+            outside++;
+        }
+    }
+    num_samples = sym;
+
+    qsort(sorted, num_samples, sizeof(unsigned int), CompareSamples);
+
+    // Both lists are sorted by address, walk them together
+    i = 0;
+    sym = -1;
+    while (i < num_samples) {
+        int next = sym + 1;
+        unsigned int count = 0;
+
+        while (next < num_symbols && symbols[next].is_data) {
+            next++;
+        }
+        if (next < num_symbols && sorted[i] >= (unsigned int)symbols[next].addr) {
+            sym = next;
+            continue;
+        }
+        while (i < num_samples && (next >= num_symbols || sorted[i] < (unsigned int)symbols[next].addr)) {
+            count++;
+            i++;
+        }
+        if (sym < 0) {
+            unknown += count;
+        } else if (count) {
+            entries[num_entries].symbol = &symbols[sym];
+            entries[num_entries].count = count;
+            num_entries++;
+        }
+    }
+    qsort(entries, num_entries, sizeof(profilerentry_t), CompareEntries);
+
+    f = fopen(PROFILER_FILE, "w");
+    if (f) {
+        unsigned int total = num_samples + outside;
+        fprintf(f, "%u samples, %u outside text, %u unresolved\n\n", total, outside, unknown);
+        fprintf(f, "  samples       %%  function\n");
+        for (sym = 0; sym < num_entries; sym++) {
+            fprintf(f, "%9u %3u.%02u%%  %s %s\n", entries[sym].count,
+                    (entries[sym].count * 100) / total,
+                    ((entries[sym].count * 10000) / total) % 100,
+                    entries[sym].symbol->name,
+                    entries[sym].symbol->module ? entries[sym].symbol->module->name : "");
+        }
+        fclose(f);
+    }
+
+    free(sorted);
+    free(entries);
+}
+
+#endif // PROFILER_ENABLED
+
+#endif // DEBUG_ENABLED || PROFILER_ENABLED
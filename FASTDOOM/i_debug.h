@@ -36,6 +36,14 @@ void I_Backtrace(const char *msg, ...);
 
 void I_DebugShutdown(void);
 
+// Timer sampling profiler, enabled with -dPROFILER_ENABLED=1
+#if (PROFILER_ENABLED == 1)
+void I_ProfilerInit(void);
+void I_ProfilerSample(unsigned int eip);
+void I_ProfilerReset(void);
+void I_ProfilerDump(void);
+#endif
+
 
 #if BOUNDS_CHECK_ENABLED == 1
 #define BOUNDS_CHECK(x, y)                                                     \
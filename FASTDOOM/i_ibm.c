@@ -52,6 +52,10 @@
 
 #include "i_log.h"
 
+#include "i_debug.h"
+
+#include "p_tick.h"
+
 #if defined(MODE_CGA_AFH)
 #include "i_cgaafh.h"
 #endif
@@ -236,7 +240,6 @@ extern int usemouse;
 byte mousepresent;
 
 unsigned int ticcount;
-unsigned int mscount;
 unsigned int fps;
 
 // REGS stuff used for int calls
@@ -555,25 +558,24 @@ extern int screenblocks;
 
 void I_CalculateFPS(void)
 {
-    static unsigned int fps_counter, fps_starttime, fps_nextcalculation;
-    unsigned int opt1, opt2;
+    static unsigned int fps_counter, fps_starttime;
+    unsigned int now, elapsed;
+
+    now = TS_GetClocks();
 
     if (fps_counter == 0)
     {
-        fps_starttime = ticcount;
+        fps_starttime = now;
     }
 
     fps_counter++;
 
-    // store a value and/or draw when data is ok:
-    if (fps_counter > (TICRATE * 2) && fps_nextcalculation < ticcount)
+    // Average the frames of the last third of a second or so,
+    // fps is in tenths
+    elapsed = now - fps_starttime;
+    if (fps_counter > 1 && elapsed >= TS_ClockRate / 3)
     {
-        // in case of a very fast system, this will limit the sampling
-        // minus 1!, exactly 35 FPS when measeraring for a longer time.
-        opt1 = 35 * 10 * (fps_counter - 1);
-        opt2 = ticcount - fps_starttime;
-        fps = opt1 / opt2;
-        fps_nextcalculation = ticcount + 12;
+        fps = (TS_ClockRate * 10) / (elapsed / (fps_counter - 1));
         fps_counter = 0; // flush old data
     }
 }
@@ -821,7 +823,8 @@ void I_TimerISR(task *task)
 
 void I_TimerMS(task *task)
 {
-    mscount++;
+    if (nodrawers)
+        thinkersamples[thinkerclass]++;
 }
 
 //
@@ -994,6 +997,12 @@ void I_Init(void)
 //
 void I_Shutdown(void)
 {
+#if (PROFILER_ENABLED == 1)
+    I_ProfilerDump();
+#endif
+#if (TRACE_ENABLED == 1)
+    I_TraceDump();
+#endif
     I_ShutdownGraphics();
     I_ShutdownSound();
     I_ShutdownTimer();
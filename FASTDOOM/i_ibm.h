@@ -4,7 +4,6 @@
 #include "options.h"
 
 extern unsigned int ticcount;
-extern unsigned int mscount;
 extern unsigned int fps;
 
 extern unsigned short *currentscreen;
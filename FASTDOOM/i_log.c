@@ -17,3 +17,55 @@ void I_Log(const char *format, ...)
 }
 
 #endif
+
+#if (TRACE_ENABLED == 1)
+
+traceevent_t traceevents[TRACE_EVENTS];
+unsigned int tracehead;
+
+//
+// I_TraceDump
+// Writes the ring, oldest event first, after a 16 byte header:
+// "FDTR", version, timestamp ticks per second, event count
+//
+void I_TraceDump(void)
+{
+    FILE *f;
+    unsigned int header[4];
+    unsigned int count;
+    unsigned int first;
+
+    if (!tracehead)
+        return;
+
+    f = fopen("TRACE.BIN", "wb");
+
+    if (!f)
+        return;
+
+    count = tracehead < TRACE_EVENTS ? tracehead : TRACE_EVENTS;
+    first = (tracehead - count) & (TRACE_EVENTS - 1);
+
+    header[0] = 'F' | ('D' << 8) | ('T' << 16) | ('R' << 24);
+    header[1] = 2;
+    header[2] = TS_ClockRate;
+    header[3] = count;
+    fwrite(header, sizeof(header), 1, f);
+
+    // The ring may wrap, write it in two pieces
+    if (first + count > TRACE_EVENTS)
+    {
+        fwrite(traceevents + first, sizeof(traceevent_t), TRACE_EVENTS - first, f);
+        fwrite(traceevents, sizeof(traceevent_t), first + count - TRACE_EVENTS, f);
+    }
+    else
+    {
+        fwrite(traceevents + first, sizeof(traceevent_t), count, f);
+    }
+
+    fclose(f);
+
+    tracehead = 0;
+}
+
+#endif
@@ -1,4 +1,74 @@
+#ifndef __I_LOG_H__
+#define __I_LOG_H__
 #include <stdio.h>
 #include <stdarg.h>
+#include "ns_task.h"
 
 void I_Log(const char *format, ...);
+
+#if (TRACE_ENABLED == 1)
+
+//
+// Binary event trace.
+// Events go to a static ring and are written to TRACE.BIN on shutdown,
+// SCRIPTS/TraceConvert turns the dump into Chrome trace JSON.
+//
+
+enum
+{
+    TRACE_TIC_BEGIN,
+    TRACE_TIC_END,
+    TRACE_STAGE_BEGIN,
+    TRACE_STAGE_END,
+    TRACE_ZONE_PURGE,
+    TRACE_LUMP_READ_BEGIN,
+    TRACE_LUMP_READ_END,
+    TRACE_COMPOSITE_BEGIN,
+    TRACE_COMPOSITE_END,
+    TRACE_SOUND_START, // arg1 sfx, arg2 channel | volume << 8 | sep << 16
+    TRACE_SOUND_STOP   // arg1 channel
+};
+
+// Frame stages, arg1 of TRACE_STAGE_BEGIN / TRACE_STAGE_END
+enum
+{
+    TRACE_STAGE_DISPLAY,
+    TRACE_STAGE_BSP,
+    TRACE_STAGE_PLANES,
+    TRACE_STAGE_MASKED,
+    TRACE_STAGE_FINISH
+};
+
+typedef struct
+{
+    unsigned int time;
+    unsigned int type;
+    int arg1;
+    int arg2;
+} traceevent_t;
+
+// Must be a power of two
+#define TRACE_EVENTS 32768
+
+extern traceevent_t traceevents[TRACE_EVENTS];
+extern unsigned int tracehead;
+
+#define I_Trace(t, a1, a2)                                              \
+    do                                                                  \
+    {                                                                   \
+        traceevent_t *ev = traceevents + (tracehead++ & (TRACE_EVENTS - 1)); \
+        ev->time = TS_GetClocks();                                      \
+        ev->type = (t);                                                 \
+        ev->arg1 = (a1);                                                \
+        ev->arg2 = (a2);                                                \
+    } while (0)
+
+void I_TraceDump(void);
+
+#else
+
+#define I_Trace(t, a1, a2) do { } while (0)
+
+#endif
+
+#endif
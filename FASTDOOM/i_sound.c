@@ -35,12 +35,16 @@
 
 #include "ns_task.h"
 #include "ns_music.h"
+#include "ns_midi.h"
+#include "ns_sbmus.h"
 #include "ns_cms.h"
 
 #include "options.h"
 
 #include "ns_cd.h"
 
+#include "i_debug.h"
+
 //
 // I_StartupTimer
 //
@@ -52,14 +56,30 @@ void I_StartupTimer(void)
 {
     printf("I_StartupTimer()\n");
     // installs master timer.  Must be done before StartupTimer()!
+#if (PROFILER_ENABLED == 1)
+    I_ProfilerInit();
+#endif
+
     tsm_task = TS_ScheduleTask(I_TimerISR, 35, 1, NULL);
     TS_Dispatch();
-    
-    if (benchmark_advanced)
+
+    // Frame times and trace timestamps read the PIT (TS_GetClocks), only
+    // the samplers need a faster interrupt
+    if (nodrawers)
     {
         tsm_ms_task = TS_ScheduleTask(I_TimerMS, 1000, 1, NULL);
         TS_Dispatch();
+
+        MIDI_Timing = nodrawers;
     }
+#if (PROFILER_ENABLED == 1)
+    else
+    {
+        // The profiler samples on every timer interrupt, give it 1 kHz
+        tsm_ms_task = TS_ScheduleTask(I_TimerMS, 1000, 1, NULL);
+        TS_Dispatch();
+    }
+#endif
 }
 
 void I_ShutdownTimer(void)
@@ -79,6 +99,7 @@ int snd_Mport; // midi variables
 int snd_Sport; // sound port
 int snd_Rate; // sound rate
 int snd_PCMRate; // sound PCM rate
+int snd_SfxCache; // KB for sound effects converted to the mix rate
 
 int snd_MusicVolume; // maximum volume for music
 int snd_SfxVolume;   // maximum volume for sound
@@ -294,3 +315,35 @@ void I_ShutdownSound(void)
     S_PauseMusic();
     ASS_DeInit();
 }
+
+//
+// I_MusicReport
+// Time spent in the MIDI service routine, the PIT runs at 1193182 Hz,
+// and OPL register writes per second
+//
+void I_MusicReport(char *buffer, unsigned int realtics)
+{
+    unsigned int clocks;
+
+    buffer[0] = '\0';
+
+    if (!realtics)
+    {
+        return;
+    }
+
+    if (MIDI_ServiceCalls)
+    {
+        // PIT clocks per second
+        clocks = MIDI_ServiceClocks / realtics * 35;
+
+        buffer += sprintf(buffer, "\nMusic ISR %u calls, %u us/s, %u ns/call\n", MIDI_ServiceCalls,
+                          clocks * 1000 / 1193, MIDI_ServiceClocks / MIDI_ServiceCalls * 838);
+    }
+
+    if (AL_Writes)
+    {
+        sprintf(buffer, "OPL writes %u/s, skipped %u/s\n",
+                AL_Writes * 35 / realtics, AL_SkippedWrites * 35 / realtics);
+    }
+}
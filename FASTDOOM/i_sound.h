@@ -50,5 +50,6 @@ typedef enum
 
 extern int snd_Rate;
 extern int snd_PCMRate;
+extern int snd_SfxCache;
 
 #endif
@@ -65,6 +65,10 @@ void I_LoopSong(int handle);
 
 void I_ResumeSong(int handle);
 
+void I_MusicReport(char *buffer, unsigned int realtics);
+// Time spent playing MIDI music in the timer interrupt and OPL register
+// writes, with -nodraw
+
 //  SFX I/O
 //
 
@@ -260,22 +260,101 @@ void M_ChangeValueFile(unsigned int position, char *token)
     }
 }
 
-void M_ParseBenchmarkLine(char *line)
+//
+// Benchmark file lines can sweep values, "high|low,3|7|11,..." runs the
+// Cartesian product of every alternative (6 runs here). The last column
+// changes fastest.
+//
+#define SWEEP_SEPARATOR '|'
+#define MAX_COLUMNS 16
+
+int M_CountSweepValues(char *token)
 {
-    unsigned int count = 0;
+    int count = 1;
+
+    while (*token)
+    {
+        if (*token == SWEEP_SEPARATOR)
+            count++;
+        token++;
+    }
+
+    return count;
+}
+
+void M_GetSweepValue(char *token, int n, char *value, int size)
+{
+    while (n > 0 && *token)
+    {
+        if (*token == SWEEP_SEPARATOR)
+            n--;
+        token++;
+    }
+
+    while (*token && *token != SWEEP_SEPARATOR && size > 1)
+    {
+        *value++ = *token++;
+        size--;
+    }
+
+    *value = '\0';
+}
+
+// Returns the number of runs of the line
+int M_SplitBenchmarkLine(char *line, char **columns, int *numcolumns)
+{
+    int runs = 1;
+    int count = 0;
     char *token = strtok(line, FILE_SEPARATOR);
-    while (token != NULL)
+
+    while (token != NULL && count < MAX_COLUMNS)
     {
-        M_ChangeValueFile(count, token);
+        columns[count] = token;
+        runs *= M_CountSweepValues(token);
         token = strtok(NULL, FILE_SEPARATOR);
         count++;
     }
+
+    *numcolumns = count;
+
+    // Empty lines don't run anything
+    if (count == 0)
+        return 0;
+
+    return runs;
+}
+
+void M_ParseBenchmarkLine(char **columns, int numcolumns, int combination)
+{
+    int selected[MAX_COLUMNS];
+    char value[32];
+    int i;
+
+    for (i = numcolumns - 1; i >= 0; i--)
+    {
+        int count = M_CountSweepValues(columns[i]);
+
+        selected[i] = combination % count;
+        combination /= count;
+    }
+
+    for (i = 0; i < numcolumns; i++)
+    {
+        M_GetSweepValue(columns[i], selected[i], value, sizeof(value));
+        M_ChangeValueFile(i, value);
+    }
 }
 
-int M_ProcessBenchmarkFile(const char *filename, int lineNumber)
+//
+// M_ProcessBenchmarkFile
+// Applies the settings of the given run, counting every sweep combination
+//
+int M_ProcessBenchmarkFile(const char *filename, int runNumber)
 {
     char buffer[1024];
-    int currentLine = 0;
+    char *columns[MAX_COLUMNS];
+    int numcolumns;
+    int runs;
 
     FILE *file = fopen(filename, "r");
 
@@ -288,12 +367,15 @@ int M_ProcessBenchmarkFile(const char *filename, int lineNumber)
 
     while (fgets(buffer, sizeof(buffer), file) != NULL)
     {
-        if (currentLine == lineNumber)
+        runs = M_SplitBenchmarkLine(buffer, columns, &numcolumns);
+
+        if (runNumber < runs)
         {
-            M_ParseBenchmarkLine(buffer);
+            M_ParseBenchmarkLine(columns, numcolumns, runNumber);
             break;
         }
-        currentLine++;
+
+        runNumber -= runs;
     }
 
     fclose(file);
@@ -301,9 +383,40 @@ int M_ProcessBenchmarkFile(const char *filename, int lineNumber)
     return 1;
 }
 
+//
+// M_CountBenchmarkFile
+// Number of runs in a benchmark file, -1 if it can't be read
+//
+int M_CountBenchmarkFile(const char *filename)
+{
+    char buffer[1024];
+    char *columns[MAX_COLUMNS];
+    int numcolumns;
+    int total = 0;
+
+    FILE *file = fopen(filename, "r");
+
+    if (file == NULL)
+        return -1;
+
+    fgets(buffer, sizeof(buffer), file); // Skip first line
+
+    while (fgets(buffer, sizeof(buffer), file) != NULL)
+    {
+        total += M_SplitBenchmarkLine(buffer, columns, &numcolumns);
+    }
+
+    fclose(file);
+
+    return total;
+}
+
 void M_UpdateSettingsFile(void)
 {
-    M_ProcessBenchmarkFile(benchmark_file, benchmark_number);
+    unsigned int demos = benchmark_demos_num ? benchmark_demos_num : 1;
+
+    // Every demo runs with the same settings before moving to the next run
+    M_ProcessBenchmarkFile(benchmark_file, benchmark_number / demos);
 }
 
 void M_UpdateSettings(void)
@@ -20,5 +20,6 @@
 #define __M_BENCH__
 
 void M_UpdateSettings(void);
+int M_CountBenchmarkFile(const char *filename);
 
 #endif
@@ -1034,11 +1034,17 @@ void M_DrawBenchmarkResult(void)
 }
 
 #define CSV_MESSAGE "Results saved on file BENCH.CSV"
+#define CSV_REPEAT_MESSAGE "Results saved on file BENCHREP.CSV"
 
 void M_DrawBenchmarkCSV(void)
 {
     if (benchmark_commandline)
-        I_Error(CSV_MESSAGE);
+    {
+        if (benchmark_repeat > 1 || benchmark_warmup > 0)
+            I_Error(CSV_REPEAT_MESSAGE);
+        else
+            I_Error(CSV_MESSAGE);
+    }
 
 #if defined(MODE_T4025) || defined(MODE_T4050)
     V_WriteTextDirect(6, 8, CSV_MESSAGE);
@@ -1079,7 +1085,7 @@ void M_ChangeBenchmarkType(int choice)
     else
     {
         sprintf(benchmark_file, benchmark_files[benchmark_type - 1]);
-        benchmark_total = D_FileGetFirstInteger(benchmark_file);
+        benchmark_total = M_CountBenchmarkFile(benchmark_file);
         csv = 1;
     }
 }
@@ -1090,24 +1096,45 @@ void M_BenchmarkRunDemo(void)
     benchmark = true;
     benchmark_finished = false;
 
+    if (benchmark_demos_num)
+        sprintf(demofile, "%s", benchmark_demos[benchmark_number % benchmark_demos_num]);
+
     M_UpdateSettings();
 
-    if (benchmark_advanced && frametime == NULL)
+    if (benchmark_advanced)
     {
-        unsigned int i;
+        // Get tics from demo, demos of a sweep can be longer than the first one
+        unsigned int tics = G_GetDemoTicks(demofile) + 10;
+
+        if (tics > benchmark_total_tics)
+        {
+            unsigned int i;
+
+            if (frametime != NULL)
+            {
+                Z_Free(frametime);
+#if (RENDERSTATS_ENABLED == 1)
+                Z_Free(framestats);
+#endif
+            }
 
-        // Get tics from demo
-        benchmark_total_tics = G_GetDemoTicks(demofile) + 10;
+            benchmark_total_tics = tics;
 
-        // Alloc memory for frametimes
-        frametime = (unsigned int *)Z_MallocUnowned(benchmark_total_tics * sizeof(unsigned int), PU_STATIC);
+            // Alloc memory for frametimes
+            frametime = (unsigned int *)Z_MallocUnowned(benchmark_total_tics * sizeof(unsigned int), PU_STATIC);
 
-        for (i = 0; i < benchmark_total_tics; i++)
-        {
-            frametime[i] = 0;
-        }
+            for (i = 0; i < benchmark_total_tics; i++)
+            {
+                frametime[i] = 0;
+            }
+
+#if (RENDERSTATS_ENABLED == 1)
+            framestats = (renderstats_t *)Z_MallocUnowned(benchmark_total_tics * sizeof(renderstats_t), PU_STATIC);
+            SetDWords(framestats, 0, (benchmark_total_tics * sizeof(renderstats_t)) / 4);
+#endif
 
-        frametime_position = 0;
+            frametime_position = 0;
+        }
     }
 
     G_TimeDemo(demofile);
@@ -2598,22 +2625,24 @@ void M_ShowBenchmarkCSVMessage(void)
 
 void M_FinishBenchmark(void)
 {
-    if (benchmark_type == 0)
+    if (benchmark_type == 0 && !benchmark_commandline)
     {
-        if (benchmark_commandline)
-        {
-            benchmark_number = 0;
-            M_ShowBenchmarkCSVMessage();
-        }
-        else
-        {
-            M_StartControlPanel();
-            itemOn = 0;
-            currentMenu = &BenchmarkResultDef;
-        }
+        M_StartControlPanel();
+        itemOn = 0;
+        currentMenu = &BenchmarkResultDef;
     }
     else
     {
+        // Same demo and settings until every repetition is done
+        benchmark_repetition++;
+
+        if (benchmark_repetition < benchmark_warmup + benchmark_repeat)
+        {
+            M_BenchmarkRunDemo();
+            return;
+        }
+
+        benchmark_repetition = 0;
         benchmark_number++;
 
         if (benchmark_number == benchmark_total)
@@ -224,6 +224,7 @@ extern int snd_Mport;
 extern int snd_Sport;
 extern int snd_Rate;
 extern int snd_PCMRate;
+extern int snd_SfxCache;
 
 typedef struct
 {
@@ -329,6 +330,7 @@ default_t defaults[] =
         {"snd_sport", &snd_Sport, 0x378},
         {"snd_rate", &snd_Rate, 2},
         {"snd_pcmrate", &snd_PCMRate, 1},
+        {"snd_sfxcache", &snd_SfxCache, 1024},
 
         {"usegamma", &usegamma, 0}
 };
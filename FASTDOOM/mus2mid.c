@@ -16,8 +16,6 @@
 // mus2mid.c - Ben Ryves 2006 - http://benryves.com - benryves@benryves.com
 // Use to convert a MUS file into a single track, type 0 MIDI file.
 
-#include <stdio.h>
-
 #include "fastmath.h"
 #include "doomtype.h"
 
@@ -77,18 +75,11 @@ static const byte midiheader[] =
 };
 
 // Cached channel velocities
-static byte channelvelocities[] =
-    {
-        127, 127, 127, 127, 127, 127, 127, 127,
-        127, 127, 127, 127, 127, 127, 127, 127};
+static byte channelvelocities[NUM_CHANNELS];
 
 // Timestamps between sequences of MUS events
 
-static unsigned int queuedtime = 0;
-
-// Counter for the length of the track
-
-static unsigned int tracksize;
+static unsigned int queuedtime;
 
 static const byte controller_map[] =
     {
@@ -97,12 +88,46 @@ static const byte controller_map[] =
 
 static int channel_map[NUM_CHANNELS];
 
+// MUS lump being read
+
+static const byte *musdata;
+static unsigned int muslength;
+static unsigned int musposition;
+
+// MIDI output, NULL while only measuring. The position is the size
+// written so far.
+
+static byte *mididata;
+static unsigned int midiposition;
+
+// Read a byte of the MUS lump, returns 1 past the end.
+
+static byte ReadByte(byte *value)
+{
+    if (musposition >= muslength)
+    {
+        return 1;
+    }
+
+    *value = musdata[musposition++];
+    return 0;
+}
+
+static void WriteByte(byte value)
+{
+    if (mididata)
+    {
+        mididata[midiposition] = value;
+    }
+
+    midiposition++;
+}
+
 // Write timestamp to a MIDI file.
 
-static byte WriteTime(unsigned int time, FILE *midioutput)
+static void WriteTime(unsigned int time)
 {
     unsigned int buffer = time & 0x7F;
-    byte writeval;
 
     while ((time >>= 7) != 0)
     {
@@ -112,14 +137,7 @@ static byte WriteTime(unsigned int time, FILE *midioutput)
 
     for (;;)
     {
-        writeval = (byte)(buffer & 0xFF);
-
-        if (fwrite(&writeval, 1, 1, midioutput) != 1)
-        {
-            return 1;
-        }
-
-        ++tracksize;
+        WriteByte((byte)(buffer & 0xFF));
 
         if ((buffer & 0x80) != 0)
         {
@@ -128,217 +146,77 @@ static byte WriteTime(unsigned int time, FILE *midioutput)
         else
         {
             queuedtime = 0;
-            return 0;
+            return;
         }
     }
 }
 
-// Write the end of track marker
-static byte WriteEndTrack(FILE *midioutput)
+// Write an event with its timestamp
+static void WriteEvent(byte status, byte data1, byte data2)
 {
-    byte endtrack[] = {0xFF, 0x2F, 0x00};
-
-    if (WriteTime(queuedtime, midioutput))
-    {
-        return 1;
-    }
-
-    if (fwrite(endtrack, 1, 3, midioutput) != 3)
-    {
-        return 1;
-    }
+    WriteTime(queuedtime);
+    WriteByte(status);
+    WriteByte(data1);
+    WriteByte(data2);
+}
 
-    tracksize += 3;
-    return 0;
+// Write the end of track marker
+static void WriteEndTrack(void)
+{
+    WriteEvent(0xFF, 0x2F, 0x00);
 }
 
 // Write a key press event
-static byte WritePressKey(byte channel, byte key, byte velocity, FILE *midioutput)
+static void WritePressKey(byte channel, byte key, byte velocity)
 {
-    byte working = midi_presskey | channel;
-
-    if (WriteTime(queuedtime, midioutput))
-    {
-        return 1;
-    }
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = key & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = velocity & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    tracksize += 3;
-
-    return 0;
+    WriteEvent(midi_presskey | channel, key & 0x7F, velocity & 0x7F);
 }
 
 // Write a key release event
-static byte WriteReleaseKey(byte channel, byte key,
-                               FILE *midioutput)
+static void WriteReleaseKey(byte channel, byte key)
 {
-    byte working = midi_releasekey | channel;
-
-    if (WriteTime(queuedtime, midioutput))
-    {
-        return 1;
-    }
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = key & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = 0;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    tracksize += 3;
-
-    return 0;
+    WriteEvent(midi_releasekey | channel, key & 0x7F, 0);
 }
 
 // Write a pitch wheel/bend event
-static byte WritePitchWheel(byte channel, short wheel,
-                               FILE *midioutput)
+static void WritePitchWheel(byte channel, short wheel)
 {
-    byte working = midi_pitchwheel | channel;
-
-    if (WriteTime(queuedtime, midioutput))
-    {
-        return 1;
-    }
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = wheel & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = (wheel >> 7) & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    tracksize += 3;
-    return 0;
+    WriteEvent(midi_pitchwheel | channel, wheel & 0x7F, (wheel >> 7) & 0x7F);
 }
 
 // Write a patch change event
-static byte WriteChangePatch(byte channel, byte patch,
-                                FILE *midioutput)
+static void WriteChangePatch(byte channel, byte patch)
 {
-    byte working = midi_changepatch | channel;
-
-    if (WriteTime(queuedtime, midioutput))
-    {
-        return 1;
-    }
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = patch & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    tracksize += 2;
-
-    return 0;
+    WriteTime(queuedtime);
+    WriteByte(midi_changepatch | channel);
+    WriteByte(patch & 0x7F);
 }
 
 // Write a valued controller change event
 
-static byte WriteChangeController_Valued(byte channel,
-                                            byte control,
-                                            byte value,
-                                            FILE *midioutput)
+static void WriteChangeController_Valued(byte channel,
+                                         byte control,
+                                         byte value)
 {
-    byte working = midi_changecontroller | channel;
-
-    if (WriteTime(queuedtime, midioutput))
-    {
-        return 1;
-    }
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    working = control & 0x7F;
-
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
     // Quirk in vanilla DOOM? MUS controller values should be
     // 7-bit, not 8-bit.
 
-    working = value; // & 0x7F;
-
     // Fix on said quirk to stop MIDI players from complaining that
     // the value is out of range:
 
-    if (working & 0x80)
+    if (value & 0x80)
     {
-        working = 0x7F;
+        value = 0x7F;
     }
 
-    if (fwrite(&working, 1, 1, midioutput) != 1)
-    {
-        return 1;
-    }
-
-    tracksize += 3;
-
-    return 0;
+    WriteEvent(midi_changecontroller | channel, control & 0x7F, value);
 }
 
 // Write a valueless controller change event
-static byte WriteChangeController_Valueless(byte channel,
-                                               byte control,
-                                               FILE *midioutput)
+static void WriteChangeController_Valueless(byte channel,
+                                            byte control)
 {
-    return WriteChangeController_Valued(channel, control, 0,
-                                        midioutput);
+    WriteChangeController_Valued(channel, control, 0);
 }
 
 // Allocate a free MIDI channel.
@@ -380,7 +258,7 @@ static int AllocateMIDIChannel(void)
 // Given a MUS channel number, get the MIDI channel number to use
 // in the outputted file.
 
-static int GetMIDIChannel(int mus_channel, FILE *midioutput)
+static int GetMIDIChannel(int mus_channel)
 {
     // Find the MIDI channel to use for this MUS channel.
     // MUS channel 15 is the percusssion channel.
@@ -401,32 +279,22 @@ static int GetMIDIChannel(int mus_channel, FILE *midioutput)
             // First time using the channel, send an "all notes off"
             // event. This fixes "The D_DDTBLU disease" described here:
             // http://www.doomworld.com/vb/source-ports/66802-the
-            WriteChangeController_Valueless(channel_map[mus_channel], 0x7b,
-                                            midioutput);
+            WriteChangeController_Valueless(channel_map[mus_channel], 0x7b);
         }
 
         return channel_map[mus_channel];
     }
 }
 
-static int ReadMusHeader(FILE *file, musheader *header)
-{
-    int result;
-
-    result = fread(&header->id, sizeof(byte), 4, file) == 4 && fread(&header->scorelength, sizeof(short), 1, file) == 1 && fread(&header->scorestart, sizeof(short), 1, file) == 1 && fread(&header->primarychannels, sizeof(short), 1, file) == 1 && fread(&header->secondarychannels, sizeof(short), 1, file) == 1 && fread(&header->instrumentcount, sizeof(short), 1, file) == 1;
-
-    return result;
-}
-
-// Read a MUS file from a stream (musinput) and output a MIDI file to
-// a stream (midioutput).
+// Convert the MUS lump to MIDI in mididata, or only measure it if
+// mididata is NULL.
 //
 // Returns 0 on success or 1 on failure.
 
-byte mus2mid(FILE *musinput, FILE *midioutput)
+static byte ConvertMus(void)
 {
     // Header for the MUS file
-    musheader musfileheader;
+    const musheader *musfileheader;
 
     // Descriptor for the current MUS event
     byte eventdescriptor;
@@ -438,8 +306,8 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
     byte controllernumber;
     byte controllervalue;
 
-    // Buffer used for MIDI track size record
-    byte tracksizebuffer[4];
+    // Counter for the length of the track
+    unsigned int tracksize;
 
     // Flag for when the score end marker is hit.
     int hitscoreend = 0;
@@ -448,37 +316,41 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
     byte working;
     // Used in building up time delays
     unsigned int timedelay;
+    unsigned int i;
 
     // Initialise channel map to mark all channels as unused.
     SetDWords(channel_map, -1, NUM_CHANNELS);
+    SetBytes(channelvelocities, 127, NUM_CHANNELS);
+    queuedtime = 0;
+    midiposition = 0;
 
     // Grab the header
 
-    if (!ReadMusHeader(musinput, &musfileheader))
+    if (muslength < sizeof(musheader))
     {
         return 1;
     }
 
+    musfileheader = (const musheader *)musdata;
+
 #ifdef CHECK_MUS_HEADER
     // Check MUS header
-    if (musfileheader.id[0] != 'M' || musfileheader.id[1] != 'U' || musfileheader.id[2] != 'S' || musfileheader.id[3] != 0x1A)
+    if (musfileheader->id[0] != 'M' || musfileheader->id[1] != 'U' || musfileheader->id[2] != 'S' || musfileheader->id[3] != 0x1A)
     {
         return 1;
     }
 #endif
 
     // Seek to where the data is held
-    if (fseek(musinput, (long)musfileheader.scorestart,
-              SEEK_SET) != 0)
-    {
-        return 1;
-    }
+    musposition = musfileheader->scorestart;
 
     // So, we can assume the MUS file is faintly legit. Let's start
     // writing MIDI data...
 
-    fwrite(midiheader, 1, sizeof(midiheader), midioutput);
-    tracksize = 0;
+    for (i = 0; i < sizeof(midiheader); ++i)
+    {
+        WriteByte(midiheader[i]);
+    }
 
     // Now, process the MUS file:
     while (!hitscoreend)
@@ -489,38 +361,34 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
         {
             // Fetch channel number and event code:
 
-            if (fread(&eventdescriptor, 1, 1, musinput) != 1)
+            if (ReadByte(&eventdescriptor))
             {
                 return 1;
             }
 
-            channel = GetMIDIChannel(eventdescriptor & 0x0F, midioutput);
+            channel = GetMIDIChannel(eventdescriptor & 0x0F);
             event = eventdescriptor & 0x70;
 
             switch (event)
             {
             case mus_releasekey:
-                if (fread(&key, 1, 1, musinput) != 1)
-                {
-                    return 1;
-                }
-
-                if (WriteReleaseKey(channel, key, midioutput))
+                if (ReadByte(&key))
                 {
                     return 1;
                 }
 
+                WriteReleaseKey(channel, key);
                 break;
 
             case mus_presskey:
-                if (fread(&key, 1, 1, musinput) != 1)
+                if (ReadByte(&key))
                 {
                     return 1;
                 }
 
                 if (key & 0x80)
                 {
-                    if (fread(&channelvelocities[channel], 1, 1, musinput) != 1)
+                    if (ReadByte(&channelvelocities[channel]))
                     {
                         return 1;
                     }
@@ -528,28 +396,20 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
                     channelvelocities[channel] &= 0x7F;
                 }
 
-                if (WritePressKey(channel, key,
-                                  channelvelocities[channel], midioutput))
-                {
-                    return 1;
-                }
-
+                WritePressKey(channel, key, channelvelocities[channel]);
                 break;
 
             case mus_pitchwheel:
-                if (fread(&key, 1, 1, musinput) != 1)
+                if (ReadByte(&key))
                 {
                     break;
                 }
-                if (WritePitchWheel(channel, (short)(key * 64), midioutput))
-                {
-                    return 1;
-                }
 
+                WritePitchWheel(channel, (short)(key * 64));
                 break;
 
             case mus_systemevent:
-                if (fread(&controllernumber, 1, 1, musinput) != 1)
+                if (ReadByte(&controllernumber))
                 {
                     return 1;
                 }
@@ -558,33 +418,23 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
                     return 1;
                 }
 
-                if (WriteChangeController_Valueless(channel,
-                                                    controller_map[controllernumber],
-                                                    midioutput))
-                {
-                    return 1;
-                }
-
+                WriteChangeController_Valueless(channel, controller_map[controllernumber]);
                 break;
 
             case mus_changecontroller:
-                if (fread(&controllernumber, 1, 1, musinput) != 1)
+                if (ReadByte(&controllernumber))
                 {
                     return 1;
                 }
 
-                if (fread(&controllervalue, 1, 1, musinput) != 1)
+                if (ReadByte(&controllervalue))
                 {
                     return 1;
                 }
 
                 if (controllernumber == 0)
                 {
-                    if (WriteChangePatch(channel, controllervalue,
-                                         midioutput))
-                    {
-                        return 1;
-                    }
+                    WriteChangePatch(channel, controllervalue);
                 }
                 else
                 {
@@ -593,13 +443,9 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
                         return 1;
                     }
 
-                    if (WriteChangeController_Valued(channel,
-                                                     controller_map[controllernumber],
-                                                     controllervalue,
-                                                     midioutput))
-                    {
-                        return 1;
-                    }
+                    WriteChangeController_Valued(channel,
+                                                 controller_map[controllernumber],
+                                                 controllervalue);
                 }
 
                 break;
@@ -623,7 +469,7 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
             timedelay = 0;
             for (;;)
             {
-                if (fread(&working, 1, 1, musinput) != 1)
+                if (ReadByte(&working))
                 {
                     return 1;
                 }
@@ -639,26 +485,38 @@ byte mus2mid(FILE *musinput, FILE *midioutput)
     }
 
     // End of track
-    if (WriteEndTrack(midioutput))
-    {
-        return 1;
-    }
+    WriteEndTrack();
 
-    // Write the track size into the stream
-    if (fseek(midioutput, 18, SEEK_SET))
+    // Write the track size into the header
+    if (mididata)
     {
-        return 1;
+        tracksize = midiposition - sizeof(midiheader);
+
+        mididata[18] = (tracksize >> 24) & 0xff;
+        mididata[19] = (tracksize >> 16) & 0xff;
+        mididata[20] = (tracksize >> 8) & 0xff;
+        mididata[21] = tracksize & 0xff;
     }
 
-    tracksizebuffer[0] = (tracksize >> 24) & 0xff;
-    tracksizebuffer[1] = (tracksize >> 16) & 0xff;
-    tracksizebuffer[2] = (tracksize >> 8) & 0xff;
-    tracksizebuffer[3] = tracksize & 0xff;
+    return 0;
+}
 
-    if (fwrite(tracksizebuffer, 1, 4, midioutput) != 4)
+// Convert a MUS lump in memory (musinput) to a MIDI file in memory
+// (midioutput). With midioutput NULL nothing is written, so the
+// caller can size the buffer first.
+//
+// Returns the size of the MIDI file, 0 on failure.
+
+unsigned int mus2mid(const byte *musinput, unsigned int muslen, byte *midioutput)
+{
+    musdata = musinput;
+    muslength = muslen;
+    mididata = midioutput;
+
+    if (ConvertMus())
     {
-        return 1;
+        return 0;
     }
 
-    return 0;
+    return midiposition;
 }
@@ -20,10 +20,8 @@
 #ifndef MUS2MID_H
 #define MUS2MID_H
 
-#include <stdio.h>
-
 typedef unsigned char byte;
 
-byte mus2mid(FILE *musinput, FILE *midioutput);
+unsigned int mus2mid(const byte *musinput, unsigned int muslen, byte *midioutput);
 
 #endif /* #ifndef MUS2MID_H */
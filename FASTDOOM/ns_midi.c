@@ -2,6 +2,7 @@
 #include <time.h>
 #include <dos.h>
 #include <string.h>
+#include <conio.h>
 #include "ns_cards.h"
 #include "ns_inter.h"
 #include "ns_dpmi.h"
@@ -25,6 +26,9 @@ static track *_MIDI_TrackPtr = NULL;
 static int _MIDI_TrackMemSize;
 static int _MIDI_NumTracks;
 
+static midievent *_MIDI_Events = NULL;
+static midievent *_MIDI_EventPtr;
+
 static int _MIDI_SongActive = FALSE;
 static int _MIDI_SongLoaded = FALSE;
 static int _MIDI_Loop = FALSE;
@@ -32,24 +36,9 @@ static int _MIDI_Loop = FALSE;
 static task *_MIDI_PlayRoutine = NULL;
 
 static int _MIDI_Division;
-static int _MIDI_Tick = 0;
-static int _MIDI_Beat = 1;
-static int _MIDI_Measure = 1;
-static unsigned _MIDI_Time;
-static int _MIDI_BeatsPerMeasure;
-static int _MIDI_TicksPerBeat;
-static int _MIDI_TimeBase;
-static long _MIDI_FPSecondsPerTick;
-static unsigned _MIDI_TotalTime;
-static int _MIDI_TotalTicks;
-static int _MIDI_TotalBeats;
-static int _MIDI_TotalMeasures;
 
 static unsigned long _MIDI_PositionInTicks;
 
-static int _MIDI_Context;
-
-static int _MIDI_ActiveTracks;
 static int _MIDI_TotalVolume = MIDI_MaxVolume;
 
 static int _MIDI_ChannelVolume[NUM_MIDI_CHANNELS];
@@ -62,6 +51,10 @@ int MIDI_Tempo = 120;
 
 char MIDI_PatchMap[128];
 
+int MIDI_Timing = FALSE;
+unsigned long MIDI_ServiceClocks;
+unsigned long MIDI_ServiceCalls;
+
 /*---------------------------------------------------------------------
    Function: _MIDI_ReadNumber
 
@@ -127,344 +120,346 @@ static long _MIDI_ReadDelta(
    Sets the track pointers to the beginning of the song.
 ---------------------------------------------------------------------*/
 
-static void _MIDI_ResetTracks(
+static int _MIDI_ResetTracks(
     void)
 
 {
     int i;
+    int active;
     track *ptr;
 
-    _MIDI_Tick = 0;
-    _MIDI_Beat = 1;
-    _MIDI_Measure = 1;
-    _MIDI_Time = 0;
-    _MIDI_BeatsPerMeasure = 4;
-    _MIDI_TicksPerBeat = _MIDI_Division;
-    _MIDI_TimeBase = 4;
-
-    _MIDI_PositionInTicks = 0;
-    _MIDI_ActiveTracks = 0;
-    _MIDI_Context = 0;
+    active = 0;
 
     ptr = _MIDI_TrackPtr;
     for (i = 0; i < _MIDI_NumTracks; i++)
     {
         ptr->pos = ptr->start;
-        ptr->delay = _MIDI_ReadDelta(ptr);
-        ptr->active = TRUE;
+        ptr->active = ptr->pos < ptr->end;
         ptr->RunningStatus = 0;
 
-        _MIDI_ActiveTracks += ptr->active != 0;
+        if (ptr->active)
+        {
+            ptr->tick = _MIDI_ReadDelta(ptr);
+            active++;
+        }
 
         ptr++;
     }
+
+    return active;
 }
 
 /*---------------------------------------------------------------------
-   Function: _MIDI_AdvanceTick
+   Function: _MIDI_MetaEvent
 
-   Increment tick counters.
+   Interpret Meta Event. Only tempo changes are kept.
 ---------------------------------------------------------------------*/
 
-static void _MIDI_AdvanceTick(void)
+static int _MIDI_MetaEvent(
+    track *Track,
+    midievent *Event)
+
 {
-    int tickDivision;
-    int beatDivision;
+    int command;
+    int length;
+    long tempo;
 
-    _MIDI_PositionInTicks++;
-    _MIDI_Time += _MIDI_FPSecondsPerTick;
+    GET_NEXT_EVENT(Track, command);
+    GET_NEXT_EVENT(Track, length);
 
-    _MIDI_Tick++;
+    tempo = 0;
 
-    if (_MIDI_TicksPerBeat != 70)
-    {
-        tickDivision = (_MIDI_Tick / _MIDI_TicksPerBeat) + 1;
-        _MIDI_Tick -= tickDivision * _MIDI_TicksPerBeat;
-    }
-    else
+    switch (command)
     {
-        tickDivision = Div70(_MIDI_Tick) + 1;
-        _MIDI_Tick -= Mul70(tickDivision);
-    }
-
-    _MIDI_Beat += tickDivision;
+    case MIDI_END_OF_TRACK:
+        Track->active = FALSE;
+        break;
 
-    if (_MIDI_BeatsPerMeasure != 4)
-    {
-        while (_MIDI_Beat > _MIDI_BeatsPerMeasure)
+    case MIDI_TEMPO_CHANGE:
+        tempo = _MIDI_ReadNumber(Track->pos, 3);
+        if (tempo)
         {
-            _MIDI_Beat -= _MIDI_BeatsPerMeasure;
-            _MIDI_Measure++;
+            tempo = min(60000000L / tempo, 0xffff);
+
+            Event->status = MIDI_META_EVENT;
+            Event->c1 = MIDI_TEMPO_CHANGE;
+            Event->c2 = tempo;
         }
+        break;
     }
-    else
-    {
-        tickDivision = (_MIDI_Tick >> 2) + 1;
-        _MIDI_Tick -= tickDivision << 2;
-        _MIDI_Beat += tickDivision;
-    }
-}
-
-/*---------------------------------------------------------------------
-   Function: _MIDI_SysEx
 
-   Interpret SysEx Event.
----------------------------------------------------------------------*/
-
-static void _MIDI_SysEx(track *Track)
-{
-    int length;
-
-    length = _MIDI_ReadDelta(Track);
     Track->pos += length;
+
+    return tempo != 0;
 }
 
 /*---------------------------------------------------------------------
-   Function: _MIDI_MetaEvent
+   Function: _MIDI_ReadEvent
 
-   Interpret Meta Event.
+   Reads the next event of a track. Returns FALSE if the event doesn't
+   have to be sent to the music device.
 ---------------------------------------------------------------------*/
 
-static void _MIDI_MetaEvent(
-    track *Track)
+static int _MIDI_ReadEvent(
+    track *Track,
+    midievent *Event)
 
 {
+    int event;
     int command;
-    int length;
-    int denominator;
-    long tempo;
+    int c1;
+    int c2;
 
-    GET_NEXT_EVENT(Track, command);
-    GET_NEXT_EVENT(Track, length);
+    Event->tick = Track->tick;
 
-    switch (command)
+    GET_NEXT_EVENT(Track, event);
+
+    if (GET_MIDI_COMMAND(event) == MIDI_SPECIAL)
     {
-    case MIDI_END_OF_TRACK:
-        Track->active = FALSE;
+        switch (event)
+        {
+        case MIDI_SYSEX:
+        case MIDI_SYSEX_CONTINUE:
+            Track->pos += _MIDI_ReadDelta(Track);
+            break;
 
-        _MIDI_ActiveTracks--;
-        break;
+        case MIDI_META_EVENT:
+            return _MIDI_MetaEvent(Track, Event);
+        }
 
-    case MIDI_TEMPO_CHANGE:
-        // VITI95: OPTIMIZE
-        tempo = 60000000L / _MIDI_ReadNumber(Track->pos, 3);
-        MIDI_SetTempo(tempo);
-        break;
+        return FALSE;
+    }
 
-    case MIDI_TIME_SIGNATURE:
-        if ((_MIDI_Tick > 0) || (_MIDI_Beat > 1))
-        {
-            _MIDI_Measure++;
-        }
+    if (event & MIDI_RUNNING_STATUS)
+    {
+        Track->RunningStatus = event;
+    }
+    else
+    {
+        event = Track->RunningStatus;
+        Track->pos--;
+    }
 
-        _MIDI_Tick = 0;
-        _MIDI_Beat = 1;
+    command = GET_MIDI_COMMAND(event);
 
-        _MIDI_BeatsPerMeasure = (int)*Track->pos;
-        denominator = (int)*(Track->pos + 1);
-        _MIDI_TimeBase = 1;
-        while (denominator > 0)
-        {
-            _MIDI_TimeBase += _MIDI_TimeBase;
-            denominator--;
-        }
-        // VITI95: OPTIMIZE
-        _MIDI_TicksPerBeat = (_MIDI_Division * 4) / _MIDI_TimeBase;
-        break;
+    if (_MIDI_CommandLengths[command] == 0)
+    {
+        return FALSE;
     }
 
-    Track->pos += length;
+    GET_NEXT_EVENT(Track, c1);
+    c2 = 0;
+    if (_MIDI_CommandLengths[command] > 1)
+    {
+        GET_NEXT_EVENT(Track, c2);
+    }
+
+    if (command == MIDI_CONTROL_CHANGE && c1 == MIDI_MONO_MODE_ON)
+    {
+        Track->pos++;
+        return FALSE;
+    }
+
+    Event->status = event;
+    Event->c1 = c1;
+    Event->c2 = c2;
+
+    return TRUE;
 }
 
 /*---------------------------------------------------------------------
-   Function: _MIDI_InterpretControllerInfo
+   Function: _MIDI_FlattenTracks
 
-   Interprets the MIDI controller info.
+   Merges the events of all the tracks in playing order, the events of
+   the same tick go by track number. The last end of track becomes the
+   end of the song. If Events is NULL the events are only counted.
 ---------------------------------------------------------------------*/
 
-static int _MIDI_InterpretControllerInfo(
-    track *Track,
-    int TimeSet,
-    int channel,
-    int c1,
-    int c2)
+static int _MIDI_FlattenTracks(
+    midievent *Events)
 
 {
-    track *trackptr;
-    int tracknum;
-    int loopcount;
+    int i;
+    int count;
+    int active;
+    unsigned long lasttick;
+    track *Track;
+    track *Next;
+    midievent event;
 
-    switch (c1)
+    count = 0;
+    lasttick = 0;
+
+    active = _MIDI_ResetTracks();
+    while (active)
     {
-    case MIDI_MONO_MODE_ON:
-        Track->pos++;
-        break;
+        Next = NULL;
+        Track = _MIDI_TrackPtr;
+        for (i = 0; i < _MIDI_NumTracks; i++)
+        {
+            if (Track->active && (Next == NULL || Track->tick < Next->tick))
+            {
+                Next = Track;
+            }
 
-    case MIDI_VOLUME:
-        _MIDI_SetChannelVolume(channel, c2);
-        break;
+            Track++;
+        }
 
-    default:
-        _MIDI_Funcs->ControlChange(channel, c1, c2);
+        if (_MIDI_ReadEvent(Next, &event))
+        {
+            if (Events)
+            {
+                Events[count] = event;
+            }
+
+            count++;
+        }
+
+        if (Next->pos >= Next->end)
+        {
+            Next->active = FALSE;
+        }
+
+        if (!Next->active)
+        {
+            lasttick = Next->tick;
+            active--;
+            continue;
+        }
+
+        Next->tick += _MIDI_ReadDelta(Next);
+    }
+
+    if (Events)
+    {
+        Events[count].tick = lasttick;
+        Events[count].status = MIDI_META_EVENT;
+        Events[count].c1 = MIDI_END_OF_TRACK;
+        Events[count].c2 = 0;
     }
 
-    return TimeSet;
+    return count + 1;
 }
 
 /*---------------------------------------------------------------------
-   Function: _MIDI_ServiceRoutine
+   Function: _MIDI_PlayTick
 
-   Task that interperates the MIDI data.
+   Sends the events of the current tick.
 ---------------------------------------------------------------------*/
-// NOTE: We have to use a stack frame here because of a strange bug
-// that occurs with Watcom.  This means that we cannot access Task!
-//Turned off to test if it works with Watcom 10a
-//#pragma aux _MIDI_ServiceRoutine frame;
-/*
-static void test
-   (
-   task *Task
-   )
-   {
-   _MIDI_ServiceRoutine( Task );
-   _MIDI_ServiceRoutine( Task );
-   _MIDI_ServiceRoutine( Task );
-   _MIDI_ServiceRoutine( Task );
-   }
-*/
-static void _MIDI_ServiceRoutine(task *Task)
+
+static void _MIDI_PlayTick(void)
 {
-    int event;
+    midievent *Event;
     int channel;
-    int command;
-    track *Track;
-    int tracknum;
-    int status;
-    int c1;
-    int c2;
-    int TimeSet;
 
-    if (!_MIDI_SongActive)
+    Event = _MIDI_EventPtr;
+    while (Event->tick == _MIDI_PositionInTicks)
     {
-        return;
-    }
+        channel = GET_MIDI_CHANNEL(Event->status);
 
-    TimeSet = FALSE;
-    Track = _MIDI_TrackPtr;
-    tracknum = 0;
-    while (tracknum < _MIDI_NumTracks)
-    {
-        while ((Track->active) && (Track->delay == 0))
+        switch (GET_MIDI_COMMAND(Event->status))
         {
-            GET_NEXT_EVENT(Track, event);
+        case MIDI_NOTE_OFF:
+            _MIDI_Funcs->NoteOff(channel, Event->c1, Event->c2);
+            break;
+
+        case MIDI_NOTE_ON:
+            _MIDI_Funcs->NoteOn(channel, Event->c1, Event->c2);
+            break;
 
-            if (GET_MIDI_COMMAND(event) == MIDI_SPECIAL)
+        case MIDI_POLY_AFTER_TCH:
+            if (_MIDI_Funcs->PolyAftertouch)
             {
-                switch (event)
-                {
-                case MIDI_SYSEX:
-                case MIDI_SYSEX_CONTINUE:
-                    //_MIDI_SysEx(Track);
-                    Track->pos += _MIDI_ReadDelta(Track);
-                    break;
-
-                case MIDI_META_EVENT:
-                    _MIDI_MetaEvent(Track);
-                    break;
-                }
-
-                if (Track->active)
-                {
-                    Track->delay = _MIDI_ReadDelta(Track);
-                }
-
-                continue;
+                _MIDI_Funcs->PolyAftertouch(channel, Event->c1, Event->c2);
             }
+            break;
 
-            if (event & MIDI_RUNNING_STATUS)
+        case MIDI_CONTROL_CHANGE:
+            if (Event->c1 == MIDI_VOLUME)
             {
-                Track->RunningStatus = event;
+                _MIDI_SetChannelVolume(channel, Event->c2);
             }
             else
             {
-                event = Track->RunningStatus;
-                Track->pos--;
+                _MIDI_Funcs->ControlChange(channel, Event->c1, Event->c2);
             }
+            break;
 
-            channel = GET_MIDI_CHANNEL(event);
-            command = GET_MIDI_COMMAND(event);
+        case MIDI_PROGRAM_CHANGE:
+            _MIDI_Funcs->ProgramChange(channel, MIDI_PatchMap[Event->c1 & 0x7f]);
+            break;
 
-            if (_MIDI_CommandLengths[command] > 0)
+        case MIDI_AFTER_TOUCH:
+            if (_MIDI_Funcs->ChannelAftertouch)
             {
-                GET_NEXT_EVENT(Track, c1);
-                if (_MIDI_CommandLengths[command] > 1)
-                {
-                    GET_NEXT_EVENT(Track, c2);
-                }
+                _MIDI_Funcs->ChannelAftertouch(channel, Event->c1);
             }
+            break;
 
-            switch (command)
+        case MIDI_PITCH_BEND:
+            _MIDI_Funcs->PitchBend(channel, Event->c1, Event->c2);
+            break;
+
+        case MIDI_SPECIAL:
+            if (Event->c1 == MIDI_TEMPO_CHANGE)
             {
-            case MIDI_NOTE_OFF:
-                _MIDI_Funcs->NoteOff(channel, c1, c2);
+                MIDI_SetTempo(Event->c2);
                 break;
+            }
 
-            case MIDI_NOTE_ON:
-                _MIDI_Funcs->NoteOn(channel, c1, c2);
-                break;
+            // End of the song, the events of tick 0 are sent right away
+            // when looping
+            _MIDI_PositionInTicks = 0;
 
-            case MIDI_POLY_AFTER_TCH:
-                if (_MIDI_Funcs->PolyAftertouch)
-                {
-                    _MIDI_Funcs->PolyAftertouch(channel, c1, c2);
-                }
-                break;
+            if (!_MIDI_Loop || Event->tick == 0)
+            {
+                _MIDI_EventPtr = _MIDI_Events;
+                _MIDI_SongActive = FALSE;
+                return;
+            }
 
-            case MIDI_CONTROL_CHANGE:
-                TimeSet = _MIDI_InterpretControllerInfo(Track, TimeSet,
-                                                        channel, c1, c2);
-                break;
+            Event = _MIDI_Events;
+            continue;
+        }
 
-            case MIDI_PROGRAM_CHANGE:
-                    _MIDI_Funcs->ProgramChange(channel, MIDI_PatchMap[c1 & 0x7f]);
-                break;
+        Event++;
+    }
 
-            case MIDI_AFTER_TOUCH:
-                if (_MIDI_Funcs->ChannelAftertouch)
-                {
-                    _MIDI_Funcs->ChannelAftertouch(channel, c1);
-                }
-                break;
+    _MIDI_EventPtr = Event;
+    _MIDI_PositionInTicks++;
+}
 
-            case MIDI_PITCH_BEND:
-                _MIDI_Funcs->PitchBend(channel, c1, c2);
-                break;
-            }
+/*---------------------------------------------------------------------
+   Function: _MIDI_ServiceRoutine
 
-            Track->delay = _MIDI_ReadDelta(Track);
-        }
+   Task that plays the MIDI events. With MIDI_Timing set the time spent
+   is measured in PIT clocks.
+---------------------------------------------------------------------*/
+
+static void _MIDI_ServiceRoutine(task *Task)
+{
+    unsigned int start;
+    unsigned int end;
 
-        Track->delay--;
-        Track++;
-        tracknum++;
+    if (!_MIDI_SongActive)
+    {
+        return;
+    }
 
-        if (_MIDI_ActiveTracks == 0)
-        {
-            _MIDI_ResetTracks();
-            if (_MIDI_Loop)
-            {
-                tracknum = 0;
-                Track = _MIDI_TrackPtr;
-            }
-            else
-            {
-                _MIDI_SongActive = FALSE;
-                break;
-            }
-        }
+    if (!MIDI_Timing)
+    {
+        _MIDI_PlayTick();
+        return;
     }
 
-    _MIDI_AdvanceTick();
+    start = TS_GetClocks();
+
+    _MIDI_PlayTick();
+
+    end = TS_GetClocks();
+
+    MIDI_ServiceClocks += end - start;
+    MIDI_ServiceCalls++;
 }
 
 /*---------------------------------------------------------------------
@@ -697,18 +692,11 @@ void MIDI_StopSong(
         _MIDI_SongLoaded = FALSE;
 
         MIDI_Reset();
-        _MIDI_ResetTracks();
-
-        USRHOOKS_FreeMem(_MIDI_TrackPtr);
 
-        _MIDI_TrackPtr = NULL;
-        _MIDI_NumTracks = 0;
-        _MIDI_TrackMemSize = 0;
+        USRHOOKS_FreeMem(_MIDI_Events);
 
-        _MIDI_TotalTime = 0;
-        _MIDI_TotalTicks = 0;
-        _MIDI_TotalBeats = 0;
-        _MIDI_TotalMeasures = 0;
+        _MIDI_Events = NULL;
+        _MIDI_EventPtr = NULL;
     }
 }
 
@@ -724,6 +712,7 @@ int MIDI_PlaySong(
 
 {
     int numtracks;
+    int numevents;
     int format;
     long headersize;
     long tracklength;
@@ -798,17 +787,38 @@ int MIDI_PlaySong(
         ptr += 8;
         CurrentTrack->start = ptr;
         ptr += tracklength;
+        CurrentTrack->end = ptr;
         CurrentTrack++;
     }
 
-    if (_MIDI_Funcs->GetVolume != NULL)
+    // The tracks are merged once here so the service routine doesn't
+    // have to parse them
+    numevents = _MIDI_FlattenTracks(NULL);
+    status = USRHOOKS_GetMem((void **)&_MIDI_Events, numevents * sizeof(midievent));
+    if (status == USRHOOKS_Ok)
     {
-        _MIDI_TotalVolume = _MIDI_Funcs->GetVolume();
+        _MIDI_FlattenTracks(_MIDI_Events);
+    }
+
+    USRHOOKS_FreeMem(_MIDI_TrackPtr);
+
+    _MIDI_TrackPtr = NULL;
+    _MIDI_NumTracks = 0;
+    _MIDI_TrackMemSize = 0;
+
+    if (status != USRHOOKS_Ok)
+    {
+        _MIDI_Events = NULL;
+        return (MIDI_NoMemory);
     }
 
-    _MIDI_InitEMIDI();
+    _MIDI_EventPtr = _MIDI_Events;
+    _MIDI_PositionInTicks = 0;
 
-    _MIDI_ResetTracks();
+    if (_MIDI_Funcs->GetVolume != NULL)
+    {
+        _MIDI_TotalVolume = _MIDI_Funcs->GetVolume();
+    }
 
     if (!Reset)
     {
@@ -846,140 +856,4 @@ void MIDI_SetTempo(int tempo)
         TS_SetTaskRate(_MIDI_PlayRoutine, tickspersecond);
         //      TS_SetTaskRate( _MIDI_PlayRoutine, tickspersecond / 4 );
     }
-    // VITI95: OPTIMIZE
-    _MIDI_FPSecondsPerTick = (1 << TIME_PRECISION) / tickspersecond;
-}
-
-/*---------------------------------------------------------------------
-   Function: MIDI_InitEMIDI
-
-   Sets up the EMIDI
----------------------------------------------------------------------*/
-
-static void _MIDI_InitEMIDI(
-    void)
-
-{
-    int event;
-    int command;
-    int channel;
-    int length;
-    int IncludeFound;
-    track *Track;
-    int tracknum;
-    int c1;
-    int c2;
-
-    _MIDI_ResetTracks();
-
-    _MIDI_TotalTime = 0;
-    _MIDI_TotalTicks = 0;
-    _MIDI_TotalBeats = 0;
-    _MIDI_TotalMeasures = 0;
-
-    Track = _MIDI_TrackPtr;
-    tracknum = 0;
-    while ((tracknum < _MIDI_NumTracks) && (Track != NULL))
-    {
-        _MIDI_Tick = 0;
-        _MIDI_Beat = 1;
-        _MIDI_Measure = 1;
-        _MIDI_Time = 0;
-        _MIDI_BeatsPerMeasure = 4;
-        _MIDI_TicksPerBeat = _MIDI_Division;
-        _MIDI_TimeBase = 4;
-
-        _MIDI_PositionInTicks = 0;
-        _MIDI_ActiveTracks = 0;
-        _MIDI_Context = -1;
-
-        Track->RunningStatus = 0;
-        Track->active = TRUE;
-
-        while (Track->delay > 0)
-        {
-            _MIDI_AdvanceTick();
-            Track->delay--;
-        }
-
-        IncludeFound = FALSE;
-        while (Track->active)
-        {
-            GET_NEXT_EVENT(Track, event);
-
-            if (GET_MIDI_COMMAND(event) == MIDI_SPECIAL)
-            {
-                switch (event)
-                {
-                case MIDI_SYSEX:
-                case MIDI_SYSEX_CONTINUE:
-                    //_MIDI_SysEx(Track);
-                    Track->pos += _MIDI_ReadDelta(Track);
-                    break;
-
-                case MIDI_META_EVENT:
-                    _MIDI_MetaEvent(Track);
-                    break;
-                }
-
-                if (Track->active)
-                {
-                    Track->delay = _MIDI_ReadDelta(Track);
-                    while (Track->delay > 0)
-                    {
-                        _MIDI_AdvanceTick();
-                        Track->delay--;
-                    }
-                }
-
-                continue;
-            }
-
-            if (event & MIDI_RUNNING_STATUS)
-            {
-                Track->RunningStatus = event;
-            }
-            else
-            {
-                event = Track->RunningStatus;
-                Track->pos--;
-            }
-
-            channel = GET_MIDI_CHANNEL(event);
-            command = GET_MIDI_COMMAND(event);
-            length = _MIDI_CommandLengths[command];
-
-            if (command == MIDI_CONTROL_CHANGE)
-            {
-                length += *Track->pos == MIDI_MONO_MODE_ON;
-                GET_NEXT_EVENT(Track, c1);
-                GET_NEXT_EVENT(Track, c2);
-                length -= 2;
-            }
-
-            Track->pos += length;
-            Track->delay = _MIDI_ReadDelta(Track);
-
-            while (Track->delay > 0)
-            {
-                _MIDI_AdvanceTick();
-                Track->delay--;
-            }
-        }
-
-        _MIDI_TotalTime = max(_MIDI_TotalTime, _MIDI_Time);
-        if (RELATIVE_BEAT(_MIDI_Measure, _MIDI_Beat, _MIDI_Tick) >
-            RELATIVE_BEAT(_MIDI_TotalMeasures, _MIDI_TotalBeats,
-                          _MIDI_TotalTicks))
-        {
-            _MIDI_TotalTicks = _MIDI_Tick;
-            _MIDI_TotalBeats = _MIDI_Beat;
-            _MIDI_TotalMeasures = _MIDI_Measure;
-        }
-
-        Track++;
-        tracknum++;
-    }
-
-    _MIDI_ResetTracks();
 }
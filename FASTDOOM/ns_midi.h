@@ -45,4 +45,9 @@ void MIDI_StopSong(void);
 int MIDI_PlaySong(unsigned char *song, int loopflag);
 void MIDI_SetTempo(int tempo);
 
+// Time spent in the service routine, in PIT clocks
+extern int MIDI_Timing;
+extern unsigned long MIDI_ServiceClocks;
+extern unsigned long MIDI_ServiceCalls;
+
 #endif
@@ -1,9 +1,6 @@
 #ifndef ___MIDI_H
 #define ___MIDI_H
 
-#define RELATIVE_BEAT(measure, beat, tick) \
-    ((tick) + ((beat) << 9) + ((measure) << 16))
-
 //Bobby Prince thinks this may be 100
 //#define GENMIDI_DefaultVolume 100
 #define GENMIDI_DefaultVolume 90
@@ -12,8 +9,6 @@
 
 #define NUM_MIDI_CHANNELS 16
 
-#define TIME_PRECISION 16
-
 #define MIDI_HEADER_SIGNATURE 0x6468544d // "MThd"
 #define MIDI_TRACK_SIGNATURE 0x6b72544d  // "MTrk"
 
@@ -57,26 +52,36 @@
 typedef struct
 {
     unsigned char *start;
+    unsigned char *end;
     unsigned char *pos;
 
-    long delay;
+    unsigned long tick;
     char active;
     short RunningStatus;
 } track;
 
+// Song event with its absolute tick, merged from all the tracks.
+// Meta events use MIDI_META_EVENT as status, c1 is the meta command
+// and c2 the tempo.
+typedef struct
+{
+    unsigned long tick;
+    unsigned char status;
+    unsigned char c1;
+    unsigned short c2;
+} midievent;
+
 static long _MIDI_ReadNumber(void *from, size_t size);
 static long _MIDI_ReadDelta(track *ptr);
-static void _MIDI_ResetTracks(void);
-static void _MIDI_AdvanceTick(void);
-static void _MIDI_MetaEvent(track *Track);
-static void _MIDI_SysEx(track *Track);
-static int _MIDI_InterpretControllerInfo(track *Track, int TimeSet,
-                                         int channel, int c1, int c2);
+static int _MIDI_ResetTracks(void);
+static int _MIDI_MetaEvent(track *Track, midievent *Event);
+static int _MIDI_ReadEvent(track *Track, midievent *Event);
+static int _MIDI_FlattenTracks(midievent *Events);
+static void _MIDI_PlayTick(void);
 //static
 static void _MIDI_ServiceRoutine(task *Task);
 static int _MIDI_SendControlChange(int channel, int c1, int c2);
 static void _MIDI_SetChannelVolume(int channel, int volume);
 static void _MIDI_SendChannelVolumes(void);
-static void _MIDI_InitEMIDI(void);
 
 #endif
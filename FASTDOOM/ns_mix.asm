@@ -362,3 +362,630 @@ exit8U:
 	pop	ecx
 	pop	ebx
         ret
+
+;================
+;
+; MV_Mix8BitMono1
+;
+;================
+
+; Same as MV_Mix8BitMono for voices already at the mix rate, the
+; source is walked one sample per output sample.
+
+; eax - position
+; edx - rate (always 0x10000)
+; ebx - start
+; ecx - number of samples to mix
+
+CODE_SYM_DEF MV_Mix8BitMono1
+        push	ebx
+	push	ecx
+	push	edx
+	push	esi
+	push	edi
+	push	ebp
+
+        mov     ebp, eax
+
+        shr     eax, 16
+        lea     esi, [ebx+eax] ; Source pointer at the current sample
+
+        ; Volume table ptr
+        mov     ebx,[_MV_LeftVolume] ; Since we're mono, use left volume
+        mov     eax,dpatch1+4
+        mov     [eax],ebx
+        mov     eax,dpatch2+4
+        mov     [eax],ebx
+
+        ; Harsh Clip table ptr
+        mov     ebx,[_MV_HarshClipTable]
+        mov     eax,dpatch3+3
+        mov     [eax],ebx
+        mov     eax,dpatch4+3
+        mov     [eax],ebx
+
+        mov     edi,[_MV_MixDestination] ; Get the position to write to
+
+        ; Number of samples to mix
+        shr     ecx, 1 ; double sample count
+        test    ecx, ecx
+        je      short exit8M1
+
+        mov     eax, ecx                        ; final position
+        shl     eax, 17
+        add     ebp, eax
+
+;     eax - scratch
+;     ebx - scratch
+;     edx - scratch
+;     ecx - count
+;     edi - destination
+;     esi - source
+;     ebp - final position
+; dpatch1 - volume table
+; dpatch2 - volume table
+; dpatch3 - harsh clip table
+; dpatch4 - harsh clip table
+
+        xor     edx, edx
+
+        align 4
+mix8M1loop:
+        movzx   eax, byte [esi]                 ; get first sample
+        movzx   ebx, byte [esi+1]               ; get second sample
+        mov     dl, byte [edi]                  ; get current sample from destination
+dpatch1:
+        movsx   eax, byte [2*eax+0x12345678]    ; volume translate first sample
+dpatch2:
+        movsx   ebx, byte [2*ebx+0x12345678]    ; volume translate second sample
+dpatch3:
+        mov     eax, [eax + edx + 0x12345678]   ; mix first sample + harsh clip new sample
+        mov     dl, byte [edi + 1]              ; get current sample from destination
+        mov     [edi], al                       ; write new sample to destination
+dpatch4:
+        mov     ebx, [ebx + edx + 0x12345678]   ; mix second sample + harsh clip new sample
+        add     esi, 2                          ; move source to third sample
+        mov     [edi + 1], bl                   ; write new sample to destination
+        add     edi, 2                          ; move destination to third sample
+        dec     ecx                             ; decrement count
+        jnz     short mix8M1loop                ; loop
+
+        mov     [_MV_MixDestination], edi       ; Store the current write position
+        mov     [_MV_MixPosition], ebp          ; return position
+exit8M1:
+        pop	ebp
+	pop	edi
+	pop	esi
+	pop	edx
+	pop	ecx
+	pop	ebx
+        ret
+
+;================
+;
+; MV_Mix8BitStereo1
+;
+;================
+
+; Same as MV_Mix8BitStereo for voices already at the mix rate.
+
+; eax - position
+; edx - rate (always 0x10000)
+; ebx - start
+; ecx - number of samples to mix
+
+CODE_SYM_DEF MV_Mix8BitStereo1
+        push	ebx
+	push	ecx
+	push	edx
+	push	esi
+	push	edi
+	push	ebp
+
+        mov     ebp, eax
+
+        shr     eax, 16
+        lea     esi, [ebx+eax] ; Source pointer at the current sample
+
+        ; Right channel offset
+        mov     ebx, [_MV_RightChannelOffset]
+        mov     eax, epatch6+2
+        mov     [eax],ebx
+        mov     eax, epatch7+2
+        mov     [eax],ebx
+
+        ; Volume table ptr
+        mov     ebx, [_MV_LeftVolume]
+        mov     eax, epatch1+4
+        mov     [eax],ebx
+
+        mov     ebx, [_MV_RightVolume]
+        mov     eax, epatch2+4
+        mov     [eax],ebx
+
+        ; Harsh Clip table ptr
+        mov     ebx, [_MV_HarshClipTable]
+        mov     eax, epatch4+2
+        mov     [eax],ebx
+        mov     eax, epatch5+2
+        mov     [eax],ebx
+
+        mov     edi, [_MV_MixDestination] ; Get the position to write to
+
+        ; Number of samples to mix
+        test    ecx, ecx
+        je      short exit8S1
+
+        mov     eax, ecx                    ; final position
+        shl     eax, 16
+        add     ebp, eax
+
+;     eax - scratch
+;     ebx - scratch
+;     edx - scratch
+;     ecx - count
+;     edi - destination
+;     esi - source
+;     ebp - final position
+; epatch1 - left volume table
+; epatch2 - right volume table
+; epatch4 - harsh clip table
+; epatch5 - harsh clip table
+
+        xor     ebx,ebx
+        mov     bl, byte [esi]              ; get first sample
+
+        xor     edx, edx
+
+        align 4
+mix8S1loop:
+        mov     dl, byte [edi]              ; get current sample from destination
+epatch1:
+        movsx   eax, byte [2*ebx+0x12345678] ; volume translate left sample
+epatch2:
+        movsx   ebx, byte [2*ebx+0x12345678] ; volume translate right sample
+        add     eax, edx                     ; mix left sample
+        inc     esi                          ; move source to second sample
+epatch6:
+        mov     dl, byte [edi+0x12345678]   ; get current sample from destination
+epatch4:
+        mov     eax, [eax + 0x12345678]      ; harsh clip left sample
+        add     ebx, edx                     ; mix right sample
+        mov     [edi], al                    ; write left sample to destination
+epatch5:
+        mov     ebx, [ebx + 0x12345678]      ; harsh clip right sample
+epatch7:
+        mov     [edi+0x12345678], bl         ; write right sample to destination
+        add     edi, 2                       ; move destination to second sample
+        xor     ebx, ebx
+        dec     ecx                          ; decrement count
+        mov     bl, byte [esi]              ; get second sample
+        jnz     short mix8S1loop                   ; loop
+
+        mov     [_MV_MixDestination], edi    ; Store the current write position
+        mov     [_MV_MixPosition], ebp       ; return position
+
+exit8S1:
+        pop	ebp
+	pop	edi
+	pop	esi
+	pop	edx
+	pop	ecx
+	pop	ebx
+        ret
+
+;================
+;
+; MV_Mix8BitUltrasound1
+;
+;================
+
+; Same as MV_Mix8BitUltrasound for voices already at the mix rate.
+
+; eax - position
+; edx - rate (always 0x10000)
+; ebx - start
+; ecx - number of samples to mix
+
+CODE_SYM_DEF MV_Mix8BitUltrasound1
+        push	ebx
+	push	ecx
+	push	edx
+	push	esi
+	push	edi
+	push	ebp
+
+        mov     ebp, eax
+
+        shr     eax, 16
+        lea     esi, [ebx+eax] ; Source pointer at the current sample
+
+        ; Right channel offset
+        mov     ebx, [_MV_RightChannelOffset]
+        mov     eax, fpatch6+2
+        mov     [eax],ebx
+        mov     eax, fpatch7+2
+        mov     [eax],ebx
+
+        ; Volume table ptr
+        mov     ebx, [_MV_LeftVolume]
+        mov     eax, fpatch1+4
+        mov     [eax],ebx
+
+        mov     ebx, [_MV_RightVolume]
+        mov     eax, fpatch2+4
+        mov     [eax],ebx
+
+        ; Harsh Clip table ptr
+        mov     ebx, [_MV_HarshClipTable]
+        mov     eax, fpatch4+2
+        mov     [eax],ebx
+        mov     eax, fpatch5+2
+        mov     [eax],ebx
+
+        mov     edi, [_MV_MixDestination] ; Get the position to write to
+
+        ; Number of samples to mix
+        test    ecx, ecx
+        je      short exit8U1
+
+        mov     eax, ecx                    ; final position
+        shl     eax, 16
+        add     ebp, eax
+
+;     eax - scratch
+;     ebx - scratch
+;     edx - scratch
+;     ecx - count
+;     edi - destination
+;     esi - source
+;     ebp - final position
+; fpatch1 - left volume table
+; fpatch2 - right volume table
+; fpatch4 - harsh clip table
+; fpatch5 - harsh clip table
+
+        xor     ebx,ebx
+        mov     bl, byte [esi]              ; get first sample
+
+        xor     edx, edx
+
+        align 4
+mix8U1loop:
+        mov     dl, byte [edi]              ; get current sample from destination
+fpatch1:
+        movsx   eax, byte [2*ebx+0x12345678] ; volume translate left sample
+fpatch2:
+        movsx   ebx, byte [2*ebx+0x12345678] ; volume translate right sample
+        add     eax, edx                     ; mix left sample
+        inc     esi                          ; move source to second sample
+fpatch6:
+        mov     dl, byte [edi+0x12345678]   ; get current sample from destination
+fpatch4:
+        mov     eax, [eax + 0x12345678]      ; harsh clip left sample
+        add     ebx, edx                     ; mix right sample
+        mov     [edi], al                    ; write left sample to destination
+fpatch5:
+        mov     ebx, [ebx + 0x12345678]      ; harsh clip right sample
+fpatch7:
+        mov     [edi+0x12345678], bl         ; write right sample to destination
+        inc     edi                          ; move destination to second sample
+        xor     ebx,ebx
+        dec     ecx                          ; decrement count
+        mov     bl, byte [esi]              ; get second sample
+        jnz     short mix8U1loop                   ; loop
+
+        mov     [_MV_MixDestination], edi    ; Store the current write position
+        mov     [_MV_MixPosition], ebp       ; return position
+
+exit8U1:
+        pop	ebp
+	pop	edi
+	pop	esi
+	pop	edx
+	pop	ecx
+	pop	ebx
+        ret
+
+;================
+;
+; MV_Accum8BitMono
+;
+;================
+
+; Adds the voice to the 16 bit accumulation buffer, nothing is clipped
+; until MV_ClipAccum.
+
+; eax - position
+; edx - rate
+; ebx - start
+; ecx - number of samples to mix
+
+CODE_SYM_DEF MV_Accum8BitMono
+        push	ebx
+	push	ecx
+	push	edx
+	push	esi
+	push	edi
+	push	ebp
+
+        mov     ebp, eax
+
+        mov     esi, ebx ; Source pointer
+
+        ; Volume table ptr
+        mov     ebx,[_MV_LeftVolume] ; Since we're mono, use left volume
+        mov     eax,gpatch1+4
+        mov     [eax],ebx
+        mov     eax,gpatch2+4
+        mov     [eax],ebx
+        mov     eax,gpatch3+4
+        mov     [eax],ebx
+
+        mov     edi,[_MV_MixDestination] ; Get the position to write to
+
+;     eax - scratch
+;     ebx - scratch
+;     ecx - count
+;     edx - sample rate
+;     edi - destination
+;     esi - source
+;     ebp - frac pointer
+; gpatch1 - volume table
+; gpatch2 - volume table
+; gpatch3 - volume table
+
+        shr     ecx, 1                          ; double sample count
+        jnc     short accMpairs                 ; odd sample first
+
+        mov     eax, ebp
+        add     ebp, edx                        ; advance frac pointer
+        shr     eax, 16
+        movzx   eax, byte [esi+eax]             ; get sample
+gpatch1:
+        movsx   eax, word [2*eax+0x12345678]    ; volume translate sample
+        add     [edi], ax                       ; accumulate
+        add     edi, 2
+
+accMpairs:
+        test    ecx, ecx
+        je      short accMdone
+
+        align 4
+accMloop:
+        mov     eax, ebp                        ; begin calculating first sample
+        add     ebp, edx                        ; advance frac pointer
+        shr     eax, 16                         ; finish calculation for first sample
+        mov     ebx, ebp                        ; begin calculating second sample
+        add     ebp, edx                        ; advance frac pointer
+        shr     ebx, 16                         ; finish calculation for second sample
+        movzx   eax, byte [esi+eax]             ; get first sample
+        movzx   ebx, byte [esi+ebx]             ; get second sample
+gpatch2:
+        movsx   eax, word [2*eax+0x12345678]    ; volume translate first sample
+gpatch3:
+        movsx   ebx, word [2*ebx+0x12345678]    ; volume translate second sample
+        add     [edi], ax                       ; accumulate first sample
+        add     [edi+2], bx                     ; accumulate second sample
+        add     edi, 4                          ; move destination to third sample
+        dec     ecx                             ; decrement count
+        jnz     short accMloop                  ; loop
+
+accMdone:
+        mov     [_MV_MixDestination], edi       ; Store the current write position
+        mov     [_MV_MixPosition], ebp          ; return position
+
+        pop	ebp
+	pop	edi
+	pop	esi
+	pop	edx
+	pop	ecx
+	pop	ebx
+        ret
+
+;================
+;
+; MV_Accum8BitStereo
+;
+;================
+
+; Adds the voice to the interleaved 16 bit accumulation buffer.
+
+; eax - position
+; edx - rate
+; ebx - start
+; ecx - number of samples to mix
+
+CODE_SYM_DEF MV_Accum8BitStereo
+        push	ebx
+	push	ecx
+	push	edx
+	push	esi
+	push	edi
+	push	ebp
+
+        mov     ebp, eax
+
+        mov     esi, ebx ; Source pointer
+
+        ; Volume table ptr
+        mov     ebx, [_MV_LeftVolume]
+        mov     eax, hpatch1+4
+        mov     [eax],ebx
+        mov     eax, hpatch3+4
+        mov     [eax],ebx
+        mov     eax, hpatch5+4
+        mov     [eax],ebx
+
+        mov     ebx, [_MV_RightVolume]
+        mov     eax, hpatch2+4
+        mov     [eax],ebx
+        mov     eax, hpatch4+4
+        mov     [eax],ebx
+        mov     eax, hpatch6+4
+        mov     [eax],ebx
+
+        mov     edi, [_MV_MixDestination] ; Get the position to write to
+
+;     eax - scratch
+;     ebx - scratch
+;     ecx - count
+;     edx - sample rate
+;     edi - destination
+;     esi - source
+;     ebp - frac pointer
+; hpatch1, hpatch3, hpatch5 - left volume table
+; hpatch2, hpatch4, hpatch6 - right volume table
+
+        shr     ecx, 1                       ; double sample count
+        jnc     short accSpairs              ; odd sample first
+
+        mov     eax, ebp
+        add     ebp, edx                     ; advance frac pointer
+        shr     eax, 16
+        movzx   ebx, byte [esi+eax]          ; get sample
+hpatch1:
+        movsx   eax, word [2*ebx+0x12345678] ; volume translate left sample
+hpatch2:
+        movsx   ebx, word [2*ebx+0x12345678] ; volume translate right sample
+        add     [edi], ax                    ; accumulate left sample
+        add     [edi+2], bx                  ; accumulate right sample
+        add     edi, 4
+
+accSpairs:
+        test    ecx, ecx
+        je      short accSdone
+
+        align 4
+accSloop:
+        mov     eax, ebp                     ; begin calculating first sample
+        add     ebp, edx                     ; advance frac pointer
+        shr     eax, 16                      ; finish calculation for first sample
+        movzx   ebx, byte [esi+eax]          ; get first sample
+hpatch3:
+        movsx   eax, word [2*ebx+0x12345678] ; volume translate left sample
+hpatch4:
+        movsx   ebx, word [2*ebx+0x12345678] ; volume translate right sample
+        add     [edi], ax                    ; accumulate left sample
+        add     [edi+2], bx                  ; accumulate right sample
+        mov     eax, ebp                     ; begin calculating second sample
+        add     ebp, edx                     ; advance frac pointer
+        shr     eax, 16                      ; finish calculation for second sample
+        movzx   ebx, byte [esi+eax]          ; get second sample
+hpatch5:
+        movsx   eax, word [2*ebx+0x12345678] ; volume translate left sample
+hpatch6:
+        movsx   ebx, word [2*ebx+0x12345678] ; volume translate right sample
+        add     [edi+4], ax                  ; accumulate left sample
+        add     [edi+6], bx                  ; accumulate right sample
+        add     edi, 8                       ; move destination to third sample
+        dec     ecx                          ; decrement count
+        jnz     short accSloop               ; loop
+
+accSdone:
+        mov     [_MV_MixDestination], edi    ; Store the current write position
+        mov     [_MV_MixPosition], ebp       ; return position
+
+        pop	ebp
+	pop	edi
+	pop	esi
+	pop	edx
+	pop	ecx
+	pop	ebx
+        ret
+
+CPU PENTIUM
+
+;================
+;
+; MV_DetectMMX
+;
+;================
+
+; Returns 1 in eax if the CPU has MMX
+
+CODE_SYM_DEF MV_DetectMMX
+        push	ebx
+	push	ecx
+	push	edx
+
+        pushfd                          ; check if CPUID is available
+        pop     eax
+        mov     ecx, eax
+        xor     eax, 0x200000           ; toggle the ID flag
+        push    eax
+        popfd
+        pushfd
+        pop     eax
+        push    ecx
+        popfd
+        xor     eax, ecx
+        and     eax, 0x200000
+        je      short nommx
+
+        mov     eax, 1                  ; feature flags
+        cpuid
+        xor     eax, eax
+        test    edx, 0x800000           ; MMX bit
+        je      short nommx
+        inc     eax
+
+nommx:
+        pop	edx
+	pop	ecx
+	pop	ebx
+        ret
+
+;================
+;
+; MV_ClipAccumMMX
+;
+;================
+
+; Clips the accumulation buffer to unsigned 8 bit samples and clears
+; it for the next page. The FPU state is saved, this runs inside the
+; sound card interrupt.
+
+; eax - accumulation buffer
+; edx - destination
+; ebx - number of samples (multiple of 8)
+
+CODE_SYM_DEF MV_ClipAccumMMX
+        push	ebx
+	push	ecx
+	push	edx
+
+        sub     esp, 108                ; FPU state
+        fsave   [esp]
+
+        mov     ecx, 0x00800080         ; silence bias
+        movd    mm7, ecx
+        punpckldq mm7, mm7
+        pxor    mm6, mm6
+
+        mov     ecx, ebx
+        shr     ecx, 3
+
+        align 4
+clipMMXloop:
+        movq    mm0, [eax]              ; get 8 accumulated samples
+        movq    mm1, [eax+8]
+        paddsw  mm0, mm7                ; center on silence
+        paddsw  mm1, mm7
+        movq    [eax], mm6              ; clear the accumulation buffer
+        movq    [eax+8], mm6
+        packuswb mm0, mm1               ; clip to 0..255
+        movq    [edx], mm0              ; write 8 samples
+        add     eax, 16
+        add     edx, 8
+        dec     ecx
+        jnz     short clipMMXloop
+
+        emms
+        frstor  [esp]
+        add     esp, 108
+
+        pop	edx
+	pop	ecx
+	pop	ebx
+        ret
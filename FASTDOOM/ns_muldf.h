@@ -42,6 +42,12 @@
 
 #define PI 3.1415926536
 
+// IMA ADPCM blocks: predictor (16 bit), step index and a pad byte, then
+// two samples per byte, low nibble first
+#define ADPCM_BLOCKSIZE 1024
+#define ADPCM_BLOCKSAMPLES ((ADPCM_BLOCKSIZE - 4) * 2)
+#define ADPCM_MAXINDEX 88
+
 typedef enum
 {
     Raw,
@@ -138,6 +144,9 @@ void MV_ServiceVoc(void);
 
 static playbackstatus MV_GetNextDemandFeedBlock(VoiceNode *voice);
 static playbackstatus MV_GetNextRawBlock(VoiceNode *voice);
+static playbackstatus MV_GetNextADPCMBlock(VoiceNode *voice);
+static void MV_DecodeADPCM(unsigned char *src, unsigned char *dest, int length);
+static void MV_CalcADPCMTables(void);
 
 VoiceNode *MV_GetVoice(int handle);
 static VoiceNode *MV_AllocVoice(int priority);
@@ -165,5 +174,12 @@ void ClearBuffer_DW(void *ptr, unsigned data, int length);
 void MV_Mix8BitMono(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
 void MV_Mix8BitStereo(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
 void MV_Mix8BitUltrasound(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
+void MV_Mix8BitMono1(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
+void MV_Mix8BitStereo1(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
+void MV_Mix8BitUltrasound1(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
+void MV_Accum8BitMono(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
+void MV_Accum8BitStereo(unsigned long position, unsigned long rate, unsigned char *start, unsigned long length);
+int MV_DetectMMX(void);
+void MV_ClipAccumMMX(short *src, char *dest, int count);
 
 #endif
@@ -57,6 +57,11 @@ static int MV_Bits = 8;
 static int MV_Silence = SILENCE_8BIT;
 static int MV_SwapLeftRight = FALSE;
 
+// All voices are added to MV_AccumBuffer and clipped once per page
+static int MV_Accumulate = FALSE;
+static int MV_MMX = FALSE;
+static short MV_AccumBuffer[MixBufferSize * 2];
+
 static int MV_RequestedMixRate;
 static int MV_MixRate;
 
@@ -71,6 +76,26 @@ char *MV_MixBuffer[NumberOfBuffers + 1];
 
 static VoiceNode *MV_Voices = NULL;
 
+static const short MV_ADPCMStep[ADPCM_MAXINDEX + 1] =
+    {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+        34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+        157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+        724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+        3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const signed char MV_ADPCMIndexStep[8] =
+    {
+        -1, -1, -1, -1, 2, 4, 6, 8};
+
+// Predictor change and next step index for every step index and code
+static int MV_ADPCMDiff[ADPCM_MAXINDEX + 1][16];
+static unsigned char MV_ADPCMNext[ADPCM_MAXINDEX + 1][16];
+
+// Decoded samples of the current ADPCM block
+static unsigned char MV_ADPCMBuffer[ADPCM_BLOCKSAMPLES];
+
 static VoiceNode VoiceList;
 static VoiceNode VoicePool;
 
@@ -119,14 +144,22 @@ static void MV_Mix(
     length = MixBufferSize;
     FixedPointBufferSize = voice->FixedPointBufferSize;
 
-    MV_MixDestination = MV_MixBuffer[buffer];
     MV_LeftVolume = voice->LeftVolume;
     MV_RightVolume = voice->RightVolume;
 
-    if ((MV_Channels == 2) && (IS_QUIET(MV_LeftVolume)))
+    if (MV_Accumulate)
     {
-        MV_LeftVolume = MV_RightVolume;
-        MV_MixDestination += MV_RightChannelOffset;
+        MV_MixDestination = (char *)MV_AccumBuffer;
+    }
+    else
+    {
+        MV_MixDestination = MV_MixBuffer[buffer];
+
+        if ((MV_Channels == 2) && (IS_QUIET(MV_LeftVolume)))
+        {
+            MV_LeftVolume = MV_RightVolume;
+            MV_MixDestination += MV_RightChannelOffset;
+        }
     }
 
     // Add this voice to the mix
@@ -157,7 +190,8 @@ static void MV_Mix(
 
         voice->mix(position, rate, start, voclength);
 
-        if (voclength & 1)
+        // The 8 bit mono kernels mix pairs and skip the odd sample
+        if (!MV_Accumulate && (voclength & 1))
         {
             MV_MixPosition += rate;
             voclength -= 1;
@@ -192,10 +226,19 @@ void MV_PlayVoice(
     VoiceNode *voice)
 
 {
+    VoiceNode *node;
     unsigned flags;
 
     flags = DisableInterrupts();
-    LL_SortedInsertion(&VoiceList, voice, prev, next, VoiceNode, priority);
+
+    // New voices are usually the most important ones, so look from the
+    // end. Older voices of the same priority stay first to be stolen.
+    node = &VoiceList;
+    while ((node->prev != &VoiceList) && (node->prev->priority > voice->priority))
+    {
+        node = node->prev;
+    }
+    LL_AddNode(node, voice, next, prev);
 
     RestoreInterrupts(flags);
 }
@@ -217,10 +260,61 @@ void MV_StopVoice(
     // move the voice from the play list to the free list
     LL_Remove(voice, next, prev);
     LL_Add(&VoicePool, voice, next, prev);
+    voice->handle = 0;
 
     RestoreInterrupts(flags);
 }
 
+/*---------------------------------------------------------------------
+   Function: MV_ClipAccum
+
+   Clips the accumulated voices into the mix buffer and clears the
+   accumulation buffer for the next page.
+---------------------------------------------------------------------*/
+
+static void MV_ClipAccum(
+    char *dest)
+
+{
+    short *src;
+    int sample;
+    int i;
+
+    src = MV_AccumBuffer;
+
+    if ((MV_SoundCard == UltraSound) && (MV_Channels == 2))
+    {
+        // Left and right channels go to separate buffers
+        for (i = 0; i < MixBufferSize; i++)
+        {
+            sample = src[0] + 0x80;
+            dest[i] = sample < 0 ? 0 : sample > 255 ? 255 : sample;
+            sample = src[1] + 0x80;
+            dest[i + MV_RightChannelOffset] = sample < 0 ? 0 : sample > 255 ? 255 : sample;
+            src[0] = 0;
+            src[1] = 0;
+            src += 2;
+        }
+        return;
+    }
+
+    if (MV_MMX)
+    {
+        MV_ClipAccumMMX(src, dest, MixBufferSize * MV_Channels);
+        return;
+    }
+
+    for (i = 0; i < MixBufferSize * MV_Channels; i += 2)
+    {
+        sample = src[i] + 0x80;
+        dest[i] = sample < 0 ? 0 : sample > 255 ? 255 : sample;
+        sample = src[i + 1] + 0x80;
+        dest[i + 1] = sample < 0 ? 0 : sample > 255 ? 255 : sample;
+        src[i] = 0;
+        src[i + 1] = 0;
+    }
+}
+
 /*---------------------------------------------------------------------
    Function: MV_ServiceVoc
 
@@ -252,6 +346,27 @@ void MV_ServiceVoc(
         MV_MixPage -= MV_NumberOfBuffers;
     }
 
+    // Mix every voice into the accumulation buffer, then clip once
+    if (MV_Accumulate && VoiceList.next != &VoiceList)
+    {
+        for (voice = VoiceList.next; voice != &VoiceList; voice = next)
+        {
+            MV_Mix(voice, MV_MixPage);
+
+            next = voice->next;
+
+            // Is this voice done?
+            if (!voice->Playing)
+            {
+                MV_StopVoice(voice);
+            }
+        }
+
+        MV_ClipAccum(MV_MixBuffer[MV_MixPage]);
+        MV_BufferEmpty[MV_MixPage] = FALSE;
+        return;
+    }
+
     // Initialize buffer
     //Commented out so that the buffer is always cleared.
     //This is so the guys at Echo Speech can mix into the
@@ -382,29 +497,111 @@ playbackstatus MV_GetNextRawBlock(
 }
 
 /*---------------------------------------------------------------------
-   Function: MV_GetVoice
+   Function: MV_DecodeADPCM
 
-   Locates the voice with the specified handle.
+   Decodes an IMA ADPCM block into unsigned 8 bit samples.
 ---------------------------------------------------------------------*/
 
-VoiceNode *MV_GetVoice(int handle)
+static void MV_DecodeADPCM(
+    unsigned char *src,
+    unsigned char *dest,
+    int length)
+
 {
-    VoiceNode *voice;
-    unsigned flags;
+    int predictor;
+    int index;
+    int code;
 
-    flags = DisableInterrupts();
+    predictor = (short)(src[0] | (src[1] << 8));
+    index = min(src[2], ADPCM_MAXINDEX);
 
-    for (voice = VoiceList.next; voice != &VoiceList; voice = voice->next)
+    src += 4;
+    for (length -= 4; length > 0; length--)
     {
-        if (handle == voice->handle)
+        code = *src & 0x0f;
+        predictor += MV_ADPCMDiff[index][code];
+        if ((unsigned)(predictor + 32768) > 65535)
         {
-            break;
+            predictor = (predictor < 0) ? -32768 : 32767;
+        }
+        index = MV_ADPCMNext[index][code];
+        *dest++ = (predictor >> 8) ^ 0x80;
+
+        code = *src++ >> 4;
+        predictor += MV_ADPCMDiff[index][code];
+        if ((unsigned)(predictor + 32768) > 65535)
+        {
+            predictor = (predictor < 0) ? -32768 : 32767;
+        }
+        index = MV_ADPCMNext[index][code];
+        *dest++ = (predictor >> 8) ^ 0x80;
+    }
+}
+
+/*---------------------------------------------------------------------
+   Function: MV_GetNextADPCMBlock
+
+   Decodes the next block of demand fed ADPCM data. Blocks are decoded
+   one at a time as the mixer reaches the end of the previous one.
+---------------------------------------------------------------------*/
+
+playbackstatus MV_GetNextADPCMBlock(
+    VoiceNode *voice)
+
+{
+    unsigned long length;
+
+    if (voice->BlockLength <= 4)
+    {
+        if (voice->DemandFeed == NULL)
+        {
+            return (NoMoreData);
+        }
+
+        (voice->DemandFeed)((char **)&voice->NextBlock, &voice->BlockLength);
+
+        if ((voice->BlockLength <= 4) || (voice->NextBlock == NULL))
+        {
+            voice->position = 0;
+            voice->length = 0;
+            voice->BlockLength = 0;
+            return (NoMoreData);
         }
     }
 
-    RestoreInterrupts(flags);
+    length = min(voice->BlockLength, ADPCM_BLOCKSIZE);
+    MV_DecodeADPCM(voice->NextBlock, MV_ADPCMBuffer, length);
+
+    voice->NextBlock += length;
+    voice->BlockLength -= length;
+
+    voice->sound = MV_ADPCMBuffer;
+    voice->position -= voice->length;
+    voice->length = ((length - 4) * 2) << 16;
+
+    return (KeepPlaying);
+}
+
+/*---------------------------------------------------------------------
+   Function: MV_GetVoice
+
+   Locates the voice with the specified handle.
+---------------------------------------------------------------------*/
 
-    if (voice == &VoiceList)
+VoiceNode *MV_GetVoice(int handle)
+{
+    VoiceNode *voice;
+    int index;
+
+    index = handle & (MV_MaxVoiceCount - 1);
+    if (handle < MV_MinVoiceHandle || index >= MV_MaxVoices || MV_Voices == NULL)
+    {
+        return NULL;
+    }
+
+    // Stopped voices have handle 0, reused ones a different handle
+    voice = &MV_Voices[index];
+    if (voice->handle != handle)
     {
         return NULL;
     }
@@ -500,34 +697,31 @@ VoiceNode *MV_AllocVoice(
     // Check if we have any free voices
     if (LL_Empty(&VoicePool, next, prev))
     {
-        // check if we have a higher priority than a voice that is playing.
+        // The play list is sorted, the first voice is the least
+        // important one. Steal it unless it's above this one.
         voice = VoiceList.next;
-        MV_Kill(voice->handle);
-    }
+        if (voice == &VoiceList || voice->priority > priority)
+        {
+            // No free voices
+            RestoreInterrupts(flags);
+            return (NULL);
+        }
 
-    // Check if any voices are in the voice pool
-    if (LL_Empty(&VoicePool, next, prev))
-    {
-        // No free voices
-        RestoreInterrupts(flags);
-        return (NULL);
+        MV_StopVoice(voice);
     }
 
     voice = VoicePool.next;
     LL_Remove(voice, next, prev);
-    RestoreInterrupts(flags);
 
-    // Find a free voice handle
-    do
+    MV_VoiceHandle++;
+    if (MV_VoiceHandle > (0x7fff >> MV_VoiceIndexBits))
     {
-        MV_VoiceHandle++;
-        if (MV_VoiceHandle < MV_MinVoiceHandle)
-        {
-            MV_VoiceHandle = MV_MinVoiceHandle;
-        }
-    } while (MV_VoicePlaying(MV_VoiceHandle));
+        MV_VoiceHandle = MV_MinVoiceHandle;
+    }
+
+    voice->handle = (MV_VoiceHandle << MV_VoiceIndexBits) | (voice - MV_Voices);
 
-    voice->handle = MV_VoiceHandle;
+    RestoreInterrupts(flags);
 
     return (voice);
 }
@@ -540,6 +734,13 @@ VoiceNode *MV_AllocVoice(
 
 void MV_SetVoicePitch(VoiceNode *voice, unsigned long rate)
 {
+    if (rate == MV_MixRate)
+    {
+        voice->RateScale = 0x10000;
+        voice->FixedPointBufferSize = (0x10000 * MixBufferSize) - 0x10000;
+        return;
+    }
+
     switch (rate)
     {
     case 11025:
@@ -556,6 +757,24 @@ void MV_SetVoicePitch(VoiceNode *voice, unsigned long rate)
     }
 }
 
+/*---------------------------------------------------------------------
+   Function: MV_GetMixRate
+
+   Returns the rate the voices are mixed at, 0 before MV_Init.
+---------------------------------------------------------------------*/
+
+int MV_GetMixRate(
+    void)
+
+{
+    if (!MV_Installed)
+    {
+        return (0);
+    }
+
+    return (MV_MixRate);
+}
+
 /*---------------------------------------------------------------------
    Function: MV_GetVolumeTable
 
@@ -604,17 +823,48 @@ static void MV_SetVoiceMixMode(
         test |= T_ULTRASOUND;
     }
 
-    switch (test)
+    if (MV_Accumulate)
     {
-    case T_8BITS | T_MONO:
-        voice->mix = MV_Mix8BitMono;
-        break;
-    case T_8BITS:
-        voice->mix = MV_Mix8BitStereo;
-        break;
-    default:
-        // Ultrasound
-        voice->mix = MV_Mix8BitUltrasound;
+        // The accumulation buffer is always interleaved
+        if (MV_Channels == 1)
+        {
+            voice->mix = MV_Accum8BitMono;
+        }
+        else
+        {
+            voice->mix = MV_Accum8BitStereo;
+        }
+    }
+    // Sounds already at the mix rate don't need fractional stepping
+    else if (voice->RateScale == 0x10000)
+    {
+        switch (test)
+        {
+        case T_8BITS | T_MONO:
+            voice->mix = MV_Mix8BitMono1;
+            break;
+        case T_8BITS:
+            voice->mix = MV_Mix8BitStereo1;
+            break;
+        default:
+            // Ultrasound
+            voice->mix = MV_Mix8BitUltrasound1;
+        }
+    }
+    else
+    {
+        switch (test)
+        {
+        case T_8BITS | T_MONO:
+            voice->mix = MV_Mix8BitMono;
+            break;
+        case T_8BITS:
+            voice->mix = MV_Mix8BitStereo;
+            break;
+        default:
+            // Ultrasound
+            voice->mix = MV_Mix8BitUltrasound;
+        }
     }
 
     RestoreInterrupts(flags);
@@ -1043,6 +1293,139 @@ int MV_PlayRaw(
     return (voice->handle);
 }
 
+/*---------------------------------------------------------------------
+   Function: MV_StartDemandFeedPlayback
+
+   Begin playback of sound data fed in blocks by the given function.
+---------------------------------------------------------------------*/
+
+int MV_StartDemandFeedPlayback(
+    void (*function)(char **ptr, unsigned long *length),
+    unsigned long rate,
+    int vol,
+    int left,
+    int right,
+    int priority)
+
+{
+    VoiceNode *voice;
+
+    // Request a voice from the voice pool
+    voice = MV_AllocVoice(priority);
+    if (voice == NULL)
+    {
+        return (MV_Error);
+    }
+
+    voice->bits = 8;
+    voice->GetSound = MV_GetNextDemandFeedBlock;
+    voice->DemandFeed = function;
+    voice->Playing = TRUE;
+    voice->sound = NULL;
+    voice->position = 0;
+    voice->BlockLength = 0;
+    voice->length = 0;
+    voice->next = NULL;
+    voice->prev = NULL;
+    voice->priority = priority;
+
+    MV_SetVoicePitch(voice, rate);
+    MV_SetVoiceVolume(voice, vol, left, right);
+    MV_PlayVoice(voice);
+
+    return (voice->handle);
+}
+
+/*---------------------------------------------------------------------
+   Function: MV_StartADPCMPlayback
+
+   Begin playback of IMA ADPCM blocks fed by the given function. The
+   feed has to hand out whole blocks.
+---------------------------------------------------------------------*/
+
+int MV_StartADPCMPlayback(
+    void (*function)(char **ptr, unsigned long *length),
+    unsigned long rate,
+    int vol,
+    int left,
+    int right,
+    int priority)
+
+{
+    VoiceNode *voice;
+
+    // Request a voice from the voice pool
+    voice = MV_AllocVoice(priority);
+    if (voice == NULL)
+    {
+        return (MV_Error);
+    }
+
+    voice->bits = 8;
+    voice->GetSound = MV_GetNextADPCMBlock;
+    voice->DemandFeed = function;
+    voice->Playing = TRUE;
+    voice->sound = NULL;
+    voice->NextBlock = NULL;
+    voice->position = 0;
+    voice->BlockLength = 0;
+    voice->length = 0;
+    voice->next = NULL;
+    voice->prev = NULL;
+    voice->priority = priority;
+
+    MV_SetVoicePitch(voice, rate);
+    MV_SetVoiceVolume(voice, vol, left, right);
+    MV_PlayVoice(voice);
+
+    return (voice->handle);
+}
+
+/*---------------------------------------------------------------------
+   Function: MV_CalcADPCMTables
+
+   Precalculates the predictor change and the next step index of every
+   ADPCM code, so the decoder doesn't test the code bits.
+---------------------------------------------------------------------*/
+
+void MV_CalcADPCMTables(
+    void)
+
+{
+    int index;
+    int code;
+    int step;
+    int diff;
+    int next;
+
+    for (index = 0; index <= ADPCM_MAXINDEX; index++)
+    {
+        step = MV_ADPCMStep[index];
+
+        for (code = 0; code < 16; code++)
+        {
+            diff = step >> 3;
+            if (code & 4)
+            {
+                diff += step;
+            }
+            if (code & 2)
+            {
+                diff += step >> 1;
+            }
+            if (code & 1)
+            {
+                diff += step >> 2;
+            }
+
+            MV_ADPCMDiff[index][code] = (code & 8) ? -diff : diff;
+
+            next = index + MV_ADPCMIndexStep[code & 7];
+            MV_ADPCMNext[index][code] = max(0, min(next, ADPCM_MAXINDEX));
+        }
+    }
+}
+
 /*---------------------------------------------------------------------
    Function: MV_CreateVolumeTable
 
@@ -1188,6 +1571,22 @@ void MV_SetReverseStereo(
     MV_SwapLeftRight = setting;
 }
 
+/*---------------------------------------------------------------------
+   Function: MV_SetAccumulate
+
+   Mixes all the voices into a 16 bit buffer that is clipped once,
+   with MMX when the CPU has it. Set before any voice plays.
+---------------------------------------------------------------------*/
+
+void MV_SetAccumulate(
+    int setting)
+
+{
+    MV_Accumulate = setting;
+    MV_MMX = setting && MV_DetectMMX();
+    SetDWords(MV_AccumBuffer, 0, sizeof(MV_AccumBuffer) / 4);
+}
+
 void MV_ReverseStereo(void)
 {
     if (MV_SwapLeftRight == TRUE)
@@ -1221,6 +1620,8 @@ int MV_Init(
         MV_Shutdown();
     }
 
+    Voices = min(Voices, MV_MaxVoiceCount);
+
     MV_TotalMemory = Voices * sizeof(VoiceNode) + sizeof(HARSH_CLIP_TABLE_8);
     status = USRHOOKS_GetMem((void **)&ptr, MV_TotalMemory);
     if (status != USRHOOKS_Ok)
@@ -1240,6 +1641,7 @@ int MV_Init(
     for (index = 0; index < Voices; index++)
     {
         LL_Add(&VoicePool, &MV_Voices[index], next, prev);
+        MV_Voices[index].handle = 0;
     }
 
     // Allocate mix buffer within 1st megabyte
@@ -1356,6 +1758,8 @@ int MV_Init(
     // Calculate pan table
     MV_CalcPanTable();
 
+    MV_CalcADPCMTables();
+
     MV_SetVolume(MV_MaxTotalVolume);
 
     // Start the playback engine
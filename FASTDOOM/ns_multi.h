@@ -3,6 +3,13 @@
 
 #define MV_MinVoiceHandle 1
 
+// Handles carry the voice index in the low bits, the rest changes on
+// every allocation. They stay below 0x8000 (PC speaker handles in dmx.c)
+#define MV_VoiceIndexBits 6
+#define MV_MaxVoiceCount (1 << MV_VoiceIndexBits)
+
+#define MV_MaxPriority 0x7fffffff
+
 extern int MV_RightChannelOffset;
 
 enum MV_Errors
@@ -39,9 +46,17 @@ void MV_StopPlayback(void);
 int MV_PlayRaw(unsigned char *ptr, unsigned long length,
                unsigned long rate, int vol, int left,
                int right, int priority);
+int MV_StartDemandFeedPlayback(void (*function)(char **ptr, unsigned long *length),
+                               unsigned long rate, int vol, int left,
+                               int right, int priority);
+int MV_StartADPCMPlayback(void (*function)(char **ptr, unsigned long *length),
+                          unsigned long rate, int vol, int left,
+                          int right, int priority);
+int MV_GetMixRate(void);
 void MV_CreateVolumeTable(int index, int volume, int MaxVolume);
 void MV_SetVolume(int volume);
 void MV_SetReverseStereo(int setting);
+void MV_SetAccumulate(int setting);
 void MV_ReverseStereo(void);
 int MV_Init(int soundcard, int MixRate, int Voices, int numchannels,
             int samplebits);
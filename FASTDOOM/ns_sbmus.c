@@ -121,6 +121,33 @@ static int AL_MaxMidiChannel = 16;
 static int AL_OPL2LPT = FALSE;
 static int AL_OPL3LPT = FALSE;
 
+// Last value written to every register of the left and right chips
+// (or OPL3 banks) with AL_REGISTER_KNOWN set, 0 if unknown. The array
+// starts zeroed, so no value is known before AL_ClearRegisters runs.
+#define AL_REGISTER_KNOWN 0x100
+
+static short AL_Registers[2][256];
+
+unsigned long AL_Writes = 0;
+unsigned long AL_SkippedWrites = 0;
+
+/*---------------------------------------------------------------------
+   Function: AL_ClearRegisters
+
+   Forgets the register values, the next writes go to the card.
+---------------------------------------------------------------------*/
+
+static void AL_ClearRegisters(void)
+{
+   int i;
+
+   for (i = 0; i < 256; i++)
+   {
+      AL_Registers[0][i] = 0;
+      AL_Registers[1][i] = 0;
+   }
+}
+
 void AL_SendOutputToPort_OPL2LPT(int port, int reg, int data)
 {
    int i;
@@ -202,12 +229,32 @@ void AL_SendOutputToPort_OPL3LPT(int port, int reg, int data)
 /*---------------------------------------------------------------------
    Function: AL_SendOutputToPort
 
-   Sends data to the Adlib using a specified port.
+   Sends data to the Adlib using a specified port. Writes of the value
+   the register already holds are skipped, except for the timer
+   registers.
 ---------------------------------------------------------------------*/
 
 void AL_SendOutputToPort(int port, int reg, int data)
 {
    int delay;
+   short *value;
+
+   data &= 0xff;
+
+   if (reg < 2 || reg > 4)
+   {
+      value = &AL_Registers[(reg >> 8) | (port == AL_RightPort && port != AL_LeftPort)][reg & 0xff];
+
+      if (*value == (data | AL_REGISTER_KNOWN))
+      {
+         AL_SkippedWrites++;
+         return;
+      }
+
+      *value = data | AL_REGISTER_KNOWN;
+   }
+
+   AL_Writes++;
 
    if (AL_OPL2LPT)
    {
@@ -868,6 +915,8 @@ void AL_Reset(
     void)
 
 {
+   AL_ClearRegisters();
+
    AL_SendOutputToPort(ADLIB_PORT, 1, 0x20);
    AL_SendOutputToPort(ADLIB_PORT, 0x08, 0);
 
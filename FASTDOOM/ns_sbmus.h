@@ -15,6 +15,10 @@ enum AL_Errors
 
 extern int ADLIB_PORT;
 
+// Register writes sent to the card and skipped as redundant
+extern unsigned long AL_Writes;
+extern unsigned long AL_SkippedWrites;
+
 void AL_SendOutputToPort(int port, int reg, int data);
 void AL_SendOutputToPort_OPL2LPT(int port, int reg, int data);
 void AL_SendOutputToPort_OPL3LPT(int port, int reg, int data);
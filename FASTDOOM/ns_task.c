@@ -15,6 +15,11 @@
 #include "options.h"
 #include "fastmath.h"
 
+#if (PROFILER_ENABLED == 1)
+#include <i86.h>
+#include "i_debug.h"
+#endif
+
 #ifdef USESTACK
 #include "ns_dpmi.h"
 #endif
@@ -60,6 +65,9 @@ static void(__interrupt __far *OldInt8)(void);
 static volatile long TaskServiceRate = 0x10000L;
 static volatile long TaskServiceCount = 0;
 
+// PIT input clocks of all the periods that have ended, see TS_GetClocks
+static volatile unsigned long TaskServiceClocks = 0;
+
 #ifndef NOINTS
 static volatile int TS_TimesInInterrupt;
 #endif
@@ -76,7 +84,11 @@ static void TS_FreeTaskList(void);
 static void TS_SetClockSpeed(long speed);
 static long TS_SetTimer(long TickBase);
 static void TS_SetTimerToMaxTaskRate(void);
+#if (PROFILER_ENABLED == 1)
+static void __interrupt __far TS_ServiceSchedule(union INTPACK r);
+#else
 static void __interrupt __far TS_ServiceSchedule(void);
+#endif
 static void __interrupt __far TS_ServiceScheduleIntEnabled(void);
 static void TS_AddTask(task *ptr);
 static int TS_Startup(void);
@@ -124,10 +136,14 @@ static void TS_FreeTaskList(void)
 
 static void TS_SetClockSpeed(long speed)
 {
+    unsigned long clocks;
     unsigned flags;
 
     flags = DisableInterrupts();
 
+    // The counter restarts, keep the part of the period that has passed
+    clocks = TS_GetClocks();
+
     if ((speed > 0) && (speed < 0x10000L))
     {
         TaskServiceRate = speed;
@@ -137,10 +153,21 @@ static void TS_SetClockSpeed(long speed)
         TaskServiceRate = 0x10000L;
     }
 
-    outp(0x43, 0x36);
+    // Rate generator instead of square wave, the counter then goes down
+    // one step per clock and TS_GetClocks can read it
+    outp(0x43, 0x34);
     outp(0x40, TaskServiceRate);
     outp(0x40, TaskServiceRate >> 8);
 
+    // A pending interrupt still adds a period, at the new rate
+    outp(0x20, 0x0a);
+    if (inp(0x20) & 1)
+    {
+        clocks -= TaskServiceRate;
+    }
+
+    TaskServiceClocks = clocks;
+
     RestoreInterrupts(flags);
 }
 
@@ -189,13 +216,23 @@ static void TS_SetTimerToMaxTaskRate(void)
 
 #ifdef NOINTS
 
+#if (PROFILER_ENABLED == 1)
+static void __interrupt __far TS_ServiceSchedule(union INTPACK r)
+#else
 static void __interrupt __far TS_ServiceSchedule(void)
+#endif
 {
     task *ptr;
     task *next;
 
     TS_InInterrupt = TRUE;
 
+    TaskServiceClocks += TaskServiceRate;
+
+#if (PROFILER_ENABLED == 1)
+    I_ProfilerSample(r.x.eip);
+#endif
+
 #ifdef USESTACK
     // save stack
     GetStack(&oldStackSelector, &oldStackPointer);
@@ -248,6 +285,7 @@ static void __interrupt __far TS_ServiceScheduleIntEnabled(void)
     task *next;
 
     TS_TimesInInterrupt++;
+    TaskServiceClocks += TaskServiceRate;
     TaskServiceCount += TaskServiceRate;
     if (TaskServiceCount > 0xffffL)
     {
@@ -403,6 +441,10 @@ static int TS_Startup(
         TaskServiceRate = 0x10000L;
         TaskServiceCount = 0;
 
+        // Rate generator mode from here on, see TS_GetClocks
+        TS_SetClockSpeed(0);
+        TaskServiceClocks = 0;
+
 #ifndef NOINTS
         TS_TimesInInterrupt = 0;
 #endif
@@ -436,6 +478,11 @@ void TS_Shutdown(
 
         TS_SetClockSpeed(0);
 
+        // Back to the square wave the BIOS set up
+        outp(0x43, 0x36);
+        outp(0x40, 0);
+        outp(0x40, 0);
+
         _dos_setvect(0x08, OldInt8);
 
 #ifdef USESTACK
@@ -603,3 +650,56 @@ void TS_SetTaskRate(
 
     RestoreInterrupts(flags);
 }
+
+/*---------------------------------------------------------------------
+   Function: TS_GetClocks
+
+   Returns the PIT input clocks (TS_ClockRate per second) since the
+   task manager started, read from the counter when asked instead of
+   counted by an interrupt. Wraps after about an hour, use differences.
+   0 until the task manager starts, the PIT is still in the BIOS square
+   wave mode then and its counter can't be read this way.
+---------------------------------------------------------------------*/
+
+unsigned long TS_GetClocks(
+    void)
+
+{
+    unsigned long clocks;
+    unsigned count;
+    unsigned pending;
+    unsigned flags;
+
+    if (!TS_Installed)
+    {
+        return (0);
+    }
+
+    flags = DisableInterrupts();
+
+    // Latch the counter, then check if the reload already raised IRQ 0
+    outp(0x43, 0x00);
+    count = inp(0x40);
+    count |= inp(0x40) << 8;
+
+    outp(0x20, 0x0a);
+    pending = inp(0x20) & 1;
+
+    // The counter goes from the rate down to 1, 0 stands for 0x10000
+    if (!count)
+    {
+        count = 0x10000;
+    }
+
+    clocks = TaskServiceClocks + TaskServiceRate - count;
+
+    // The period ended but its interrupt hasn't run yet
+    if (pending && count > (TaskServiceRate >> 1))
+    {
+        clocks += TaskServiceRate;
+    }
+
+    RestoreInterrupts(flags);
+
+    return (clocks);
+}
@@ -26,11 +26,18 @@ typedef struct task
 
 extern volatile int TS_InInterrupt;
 
+// PIT input clock, the unit of TS_GetClocks
+#define TS_ClockRate 1193182L
+
+// Microseconds per clock in 16.16 (1000000 / TS_ClockRate)
+#define TS_MicrosecondsPerClock 54925
+
 void TS_Shutdown(void);
 task *TS_ScheduleTask(void (*Function)(task *), int rate,
                       int priority, void *data);
 int TS_Terminate(task *ptr);
 void TS_Dispatch(void);
 void TS_SetTaskRate(task *Task, int rate);
+unsigned long TS_GetClocks(void);
 
 #endif
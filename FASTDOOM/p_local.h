@@ -62,6 +62,9 @@
 // both the head and tail of the thinker list
 extern thinker_t thinkercap;
 
+// mobjs that never think, out of the tic loop
+extern thinker_t ticklesscap;
+
 void P_InitThinkers(void);
 
 //
@@ -130,7 +133,7 @@ typedef struct
 
 #define MAXINTERCEPTS 128
 
-extern intercept_t intercepts[MAXINTERCEPTS];
+extern intercept_t *intercepts;
 extern intercept_t *intercept_p;
 
 typedef byte (*traverser_t)(intercept_t *in);
@@ -182,7 +185,13 @@ byte P_NotCheckPosition(mobj_t *thing, fixed_t x, fixed_t y);
 byte P_TryMove(mobj_t *thing, fixed_t x, fixed_t y);
 byte P_TeleportMove(mobj_t *thing, fixed_t x, fixed_t y);
 void P_SlideMove(mobj_t *mo);
+extern int sightstamp;
+extern unsigned int sightchecks;
+extern unsigned int sighthits;
+
 byte P_CheckSight(mobj_t *t1, mobj_t *t2);
+void P_SightReport(char *buffer);
+void P_LoadVisMatrix(char *mapname, int rejectlump);
 void P_UseLines(void);
 
 byte P_ChangeSector(sector_t *sector, byte crunch);
@@ -215,6 +224,7 @@ extern int bmapheight; // in mapblocks
 extern fixed_t bmaporgx;
 extern fixed_t bmaporgy;    // origin of block map
 extern mobj_t **blocklinks; // for thing chains
+extern int levelgeneration; // incremented on every level load
 
 // LUT bmapwidth muls
 extern int *bmapwidthmuls;
@@ -30,6 +30,8 @@
 #include "r_state.h"
 
 #include "std_func.h"
+#include "fastmath.h"
+#include "z_zone.h"
 
 //
 // P_AproxDistance
@@ -438,11 +440,68 @@ byte P_NotBlockThingsIterator2(int x, int y, byte (*func)(mobj_t *))
 //
 // INTERCEPT ROUTINES
 //
-intercept_t intercepts[MAXINTERCEPTS];
+// Intercepts are kept sorted by frac as they are added, so the
+// traversal is a single pass. The buffer starts with a static array
+// and doubles on the zone heap when a trace crosses more than that.
+intercept_t interceptsstatic[MAXINTERCEPTS];
+intercept_t *intercepts = interceptsstatic;
 intercept_t *intercept_p;
+intercept_t *intercept_end = interceptsstatic + MAXINTERCEPTS;
 
 divline_t trace;
 
+//
+// P_GrowIntercepts
+//
+void P_GrowIntercepts(void)
+{
+    int count = intercept_p - intercepts;
+    int size = (intercept_end - intercepts) * 2;
+    intercept_t *buffer;
+
+    buffer = (intercept_t *)Z_MallocUnowned(size * sizeof(intercept_t), PU_STATIC);
+    CopyBytes(intercepts, buffer, count * sizeof(intercept_t));
+
+    if (intercepts != interceptsstatic)
+        Z_Free(intercepts);
+
+    intercepts = buffer;
+    intercept_p = buffer + count;
+    intercept_end = buffer + size;
+}
+
+//
+// P_AddIntercept
+// Inserts after any intercept with the same frac, so equal
+// distances are traversed in the order they were found.
+// Intercepts beyond the end of the trace are never traversed,
+// so they are not stored at all.
+//
+void P_AddIntercept(fixed_t frac, byte isaline, void *ptr)
+{
+    intercept_t *in;
+
+    if (frac > FRACUNIT)
+        return;
+
+    if (intercept_p == intercept_end)
+        P_GrowIntercepts();
+
+    in = intercept_p++;
+
+    // Blocks are walked along the trace, so new intercepts
+    // usually belong at or near the end
+    while (in > intercepts && in[-1].frac > frac)
+    {
+        *in = in[-1];
+        in--;
+    }
+
+    in->frac = frac;
+    in->isaline = isaline;
+    in->d.line = (line_t *)ptr;
+}
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -486,10 +545,7 @@ byte PIT_AddLineIntercepts(line_t *ld)
     if (frac < 0)
         return 1; // behind source
 
-    intercept_p->frac = frac;
-    intercept_p->isaline = 1;
-    intercept_p->d.line = ld;
-    intercept_p++;
+    P_AddIntercept(frac, 1, ld);
 
     return 1; // continue
 }
@@ -548,10 +604,7 @@ byte PIT_AddThingIntercepts(mobj_t *thing)
     if (frac < 0)
         return 1; // behind source
 
-    intercept_p->frac = frac;
-    intercept_p->isaline = 0;
-    intercept_p->d.thing = thing;
-    intercept_p++;
+    P_AddIntercept(frac, 0, thing);
 
     return 1; // keep going
 }
@@ -563,28 +616,12 @@ byte PIT_AddThingIntercepts(mobj_t *thing)
 //
 void P_TraverseIntercepts(traverser_t func)
 {
-    int count;
-    count = intercept_p - intercepts;
+    intercept_t *in;
 
-    while (count--)
+    for (in = intercepts; in < intercept_p; in++)
     {
-        fixed_t dist = MAXINT;
-        intercept_t *scan;
-        intercept_t *in;
-
-        for (scan = intercepts; scan < intercept_p; scan++)
-        {
-            if (scan->frac < dist)
-            {
-                dist = scan->frac;
-                in = scan;
-            }
-        }
-
-        if (dist > FRACUNIT || !func(in))
-            return; // checked everything in range, don't bother going farther
-
-        in->frac = MAXINT;
+        if (!func(in))
+            return; // don't bother going farther
     }
 
     return; // everything was traversed
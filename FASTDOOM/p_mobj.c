@@ -501,10 +501,20 @@ P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, byte type)
             mobj->thinker.function.acp1 = (actionf_p1)P_MobjTicklessThinker;
     }
 
-    thinkercap.prev->next = &mobj->thinker;
-    mobj->thinker.next = &thinkercap;
-    mobj->thinker.prev = thinkercap.prev;
-    thinkercap.prev = &mobj->thinker;
+    if (mobj->thinker.function.acp1 == (actionf_p1)P_MobjTicklessThinker)
+    {
+        ticklesscap.prev->next = &mobj->thinker;
+        mobj->thinker.next = &ticklesscap;
+        mobj->thinker.prev = ticklesscap.prev;
+        ticklesscap.prev = &mobj->thinker;
+    }
+    else
+    {
+        thinkercap.prev->next = &mobj->thinker;
+        mobj->thinker.next = &thinkercap;
+        mobj->thinker.prev = thinkercap.prev;
+        thinkercap.prev = &mobj->thinker;
+    }
 
     return mobj;
 }
@@ -536,6 +546,18 @@ void P_RemoveMobj(mobj_t *mobj)
     // stop any playing sound
     S_StopSound(mobj);
 
+    // tickless mobjs are freed by the tic loop too
+    if (mobj->thinker.function.acp1 == (actionf_p1)P_MobjTicklessThinker)
+    {
+        mobj->thinker.next->prev = mobj->thinker.prev;
+        mobj->thinker.prev->next = mobj->thinker.next;
+
+        thinkercap.prev->next = &mobj->thinker;
+        mobj->thinker.next = &thinkercap;
+        mobj->thinker.prev = thinkercap.prev;
+        thinkercap.prev = &mobj->thinker;
+    }
+
     // free block
     mobj->thinker.function.acv = (actionf_v)(-1);
 }
@@ -25,6 +25,9 @@
 // State.
 #include "doomstat.h"
 #include "r_state.h"
+#include "i_random.h"
+#include "p_saveg.h"
+#include "s_sound.h"
 
 byte *save_p;
 
@@ -193,15 +196,14 @@ typedef enum
 } thinkerclass_t;
 
 //
-// P_ArchiveThinkers
+// P_ArchiveMobjs
 //
-void P_ArchiveThinkers(void)
+void P_ArchiveMobjs(thinker_t *cap)
 {
 	thinker_t *th;
 	mobj_t *mobj;
 
-	// save off the current thinkers
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = cap->next; th != cap; th = th->next)
 	{
 		if (th->function.acp1 == (actionf_p1)P_MobjThinker || th->function.acp1 == (actionf_p1)P_MobjBrainlessThinker || th->function.acp1 == (actionf_p1)P_MobjTicklessThinker)
 		{
@@ -218,6 +220,16 @@ void P_ArchiveThinkers(void)
 			continue;
 		}
 	}
+}
+
+//
+// P_ArchiveThinkers
+//
+void P_ArchiveThinkers(void)
+{
+	// save off the current thinkers
+	P_ArchiveMobjs(&thinkercap);
+	P_ArchiveMobjs(&ticklesscap);
 
 	// add a terminating marker
 	*save_p++ = tc_end;
@@ -233,7 +245,16 @@ void P_UnArchiveThinkers(void)
 	thinker_t *next;
 	mobj_t *mobj;
 
-	// remove all the current thinkers
+	// remove all the current thinkers, tickless mobjs are moved to
+	// the thinker list when removed
+	currentthinker = ticklesscap.next;
+	while (currentthinker != &ticklesscap)
+	{
+		next = currentthinker->next;
+		P_RemoveMobj((mobj_t *)currentthinker);
+		currentthinker = next;
+	}
+
 	currentthinker = thinkercap.next;
 	while (currentthinker != &thinkercap)
 	{
@@ -588,3 +609,383 @@ void P_UnArchiveSpecials(void)
 		}
 	}
 }
+
+//
+// In-memory snapshots.
+// Unlike savegames they keep everything the simulation uses (thinker order,
+// targets, blockmap and sector links, removed thinkers not yet freed), so
+// a restored game continues exactly like the original one. Thinkers keep
+// raw pointers into the level (subsectors, sectors, lines), so a snapshot
+// is only valid for the level load it was taken on and restored in place.
+//
+
+extern mobj_t *braintargets[32];
+extern int numbraintargets;
+extern int braintargeton;
+extern mapthing_t itemrespawnque[ITEMQUESIZE];
+extern int itemrespawntime[ITEMQUESIZE];
+
+struct snapshot_s
+{
+	// Level load the snapshot belongs to
+	int levelgeneration;
+
+	int numthinkers;
+	int numtickless; // the last ones, linked to ticklesscap
+
+	int leveltime;
+	byte prndindex;
+	int totalkills;
+	int totalitems;
+	int totalsecret;
+
+	player_t players;
+	mobj_t *players_mo;
+
+	ceiling_t *activeceilings[MAXCEILINGS];
+	plat_t *activeplats[MAXPLATS];
+	button_t buttonlist[MAXBUTTONS];
+
+	mobj_t *braintargets[32];
+	int numbraintargets;
+	int braintargeton;
+
+	mapthing_t itemrespawnque[ITEMQUESIZE];
+	int itemrespawntime[ITEMQUESIZE];
+	int iquehead;
+	int iquetail;
+
+	// Followed by the thinkers (snapthinker_t + data), sectors, lines,
+	// sides and blocklinks
+};
+
+typedef struct
+{
+	int size;
+	int tag;
+} snapthinker_t;
+
+#define SNAP_BLOCK(th) ((memblock_t *)((byte *)(th) - sizeof(memblock_t)))
+#define SNAP_ISMOBJ(th) ((th)->function.acp1 == (actionf_p1)P_MobjThinker || (th)->function.acp1 == (actionf_p1)P_MobjBrainlessThinker || (th)->function.acp1 == (actionf_p1)P_MobjTicklessThinker)
+
+thinker_t **snaptable;
+int snapcount;
+
+//
+// Thinker pointer to index + 1 (0 is NULL). While saving, the prev link of
+// every thinker holds its index, pointers to freed memory become NULL.
+//
+void *P_SnapshotIndex(void *ptr)
+{
+	int index;
+
+	if (!ptr)
+		return NULL;
+
+	index = (int)((thinker_t *)ptr)->prev;
+
+	if (index < 0 || index >= snapcount || snaptable[index] != ptr)
+		return NULL;
+
+	return (void *)(index + 1);
+}
+
+void *P_SnapshotPointer(void *index)
+{
+	if (!index)
+		return NULL;
+
+	return snaptable[(int)index - 1];
+}
+
+//
+// P_TakeSnapshot
+//
+snapshot_t *P_TakeSnapshot(void)
+{
+	snapshot_t *snapshot;
+	thinker_t *th;
+	byte *data;
+	int size;
+	int i;
+	int blocks = bmapwidth * bmapheight;
+
+	// Count and size the thinkers
+	snapcount = 0;
+	size = sizeof(snapshot_t);
+
+	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	{
+		snapcount++;
+		size += sizeof(snapthinker_t) + SNAP_BLOCK(th)->size - sizeof(memblock_t);
+	}
+
+	for (th = ticklesscap.next; th != &ticklesscap; th = th->next)
+	{
+		snapcount++;
+		size += sizeof(snapthinker_t) + SNAP_BLOCK(th)->size - sizeof(memblock_t);
+	}
+
+	size += numsectors * sizeof(sector_t) + numlines * sizeof(line_t) + numsides * sizeof(side_t) + blocks * sizeof(mobj_t *);
+
+	snapshot = Z_MallocUnowned(size, PU_STATIC);
+	snaptable = Z_MallocUnowned((snapcount + 1) * sizeof(thinker_t *), PU_STATIC);
+
+	// Number the thinkers
+	for (i = 0, th = thinkercap.next; th != &thinkercap; i++, th = th->next)
+		snaptable[i] = th;
+
+	snapshot->numtickless = snapcount - i;
+
+	for (th = ticklesscap.next; th != &ticklesscap; i++, th = th->next)
+		snaptable[i] = th;
+
+	for (i = 0; i < snapcount; i++)
+		snaptable[i]->prev = (thinker_t *)i;
+
+	snapshot->levelgeneration = levelgeneration;
+	snapshot->numthinkers = snapcount;
+
+	data = (byte *)(snapshot + 1);
+
+	for (i = 0; i < snapcount; i++)
+	{
+		snapthinker_t *header = (snapthinker_t *)data;
+
+		th = snaptable[i];
+		header->size = SNAP_BLOCK(th)->size - sizeof(memblock_t);
+		header->tag = SNAP_BLOCK(th)->tag;
+		data += sizeof(snapthinker_t);
+
+		CopyBytes(th, data, header->size);
+
+		if (SNAP_ISMOBJ(th))
+		{
+			mobj_t *mobj = (mobj_t *)data;
+
+			mobj->snext = P_SnapshotIndex(mobj->snext);
+			mobj->sprev = P_SnapshotIndex(mobj->sprev);
+			mobj->bnext = P_SnapshotIndex(mobj->bnext);
+			mobj->bprev = P_SnapshotIndex(mobj->bprev);
+			mobj->target = P_SnapshotIndex(mobj->target);
+			mobj->tracer = P_SnapshotIndex(mobj->tracer);
+		}
+
+		data += header->size;
+	}
+
+	for (i = 0; i < numsectors; i++)
+	{
+		sector_t *sector = (sector_t *)data;
+
+		CopyBytes(&sectors[i], sector, sizeof(sector_t));
+		sector->soundtarget = P_SnapshotIndex(sector->soundtarget);
+		sector->thinglist = P_SnapshotIndex(sector->thinglist);
+		sector->specialdata = P_SnapshotIndex(sector->specialdata);
+		data += sizeof(sector_t);
+	}
+
+	for (i = 0; i < numlines; i++)
+	{
+		line_t *line = (line_t *)data;
+
+		CopyBytes(&lines[i], line, sizeof(line_t));
+		line->specialdata = P_SnapshotIndex(line->specialdata);
+		data += sizeof(line_t);
+	}
+
+	CopyBytes(sides, data, numsides * sizeof(side_t));
+	data += numsides * sizeof(side_t);
+
+	for (i = 0; i < blocks; i++)
+	{
+		((mobj_t **)data)[i] = P_SnapshotIndex(blocklinks[i]);
+	}
+
+	snapshot->leveltime = leveltime;
+	snapshot->prndindex = prndindex;
+	snapshot->totalkills = totalkills;
+	snapshot->totalitems = totalitems;
+	snapshot->totalsecret = totalsecret;
+
+	CopyBytes(&players, &snapshot->players, sizeof(player_t));
+	snapshot->players.mo = P_SnapshotIndex(players.mo);
+	snapshot->players.attacker = P_SnapshotIndex(players.attacker);
+	snapshot->players_mo = P_SnapshotIndex(players_mo);
+
+	for (i = 0; i < MAXCEILINGS; i++)
+		snapshot->activeceilings[i] = P_SnapshotIndex(activeceilings[i]);
+
+	for (i = 0; i < MAXPLATS; i++)
+		snapshot->activeplats[i] = P_SnapshotIndex(activeplats[i]);
+
+	CopyBytes(buttonlist, snapshot->buttonlist, sizeof(buttonlist));
+
+	for (i = 0; i < 32; i++)
+		snapshot->braintargets[i] = P_SnapshotIndex(braintargets[i]);
+
+	snapshot->numbraintargets = numbraintargets;
+	snapshot->braintargeton = braintargeton;
+
+	CopyBytes(itemrespawnque, snapshot->itemrespawnque, sizeof(itemrespawnque));
+	CopyBytes(itemrespawntime, snapshot->itemrespawntime, sizeof(itemrespawntime));
+	snapshot->iquehead = iquehead;
+	snapshot->iquetail = iquetail;
+
+	// Restore the thinker links
+	thinkercap.next->prev = &thinkercap;
+
+	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		th->next->prev = th;
+
+	ticklesscap.next->prev = &ticklesscap;
+
+	for (th = ticklesscap.next; th != &ticklesscap; th = th->next)
+		th->next->prev = th;
+
+	Z_Free(snaptable);
+
+	return snapshot;
+}
+
+//
+// P_RestoreSnapshot
+// Returns false if the snapshot belongs to another level load
+//
+boolean P_RestoreSnapshot(snapshot_t *snapshot)
+{
+	thinker_t *th;
+	thinker_t *next;
+	byte *data;
+	int i;
+	int blocks = bmapwidth * bmapheight;
+
+	if (snapshot->levelgeneration != levelgeneration)
+		return false;
+
+	// Sounds can be attached to the mobjs about to be freed
+	S_StopSounds();
+
+	th = thinkercap.next;
+	while (th != &thinkercap)
+	{
+		next = th->next;
+		Z_Free(th);
+		th = next;
+	}
+
+	th = ticklesscap.next;
+	while (th != &ticklesscap)
+	{
+		next = th->next;
+		Z_Free(th);
+		th = next;
+	}
+
+	P_InitThinkers();
+
+	snapcount = snapshot->numthinkers;
+	snaptable = Z_MallocUnowned((snapcount + 1) * sizeof(thinker_t *), PU_STATIC);
+
+	// Allocate and relink every thinker in the original order
+	data = (byte *)(snapshot + 1);
+
+	for (i = 0; i < snapcount; i++)
+	{
+		snapthinker_t *header = (snapthinker_t *)data;
+		thinker_t *cap = i < snapcount - snapshot->numtickless ? &thinkercap : &ticklesscap;
+
+		data += sizeof(snapthinker_t);
+
+		th = Z_MallocUnowned(header->size, header->tag);
+		CopyBytes(data, th, header->size);
+		snaptable[i] = th;
+
+		cap->prev->next = th;
+		th->next = cap;
+		th->prev = cap->prev;
+		cap->prev = th;
+
+		data += header->size;
+	}
+
+	for (i = 0; i < snapcount; i++)
+	{
+		th = snaptable[i];
+
+		if (SNAP_ISMOBJ(th))
+		{
+			mobj_t *mobj = (mobj_t *)th;
+
+			mobj->snext = P_SnapshotPointer(mobj->snext);
+			mobj->sprev = P_SnapshotPointer(mobj->sprev);
+			mobj->bnext = P_SnapshotPointer(mobj->bnext);
+			mobj->bprev = P_SnapshotPointer(mobj->bprev);
+			mobj->target = P_SnapshotPointer(mobj->target);
+			mobj->tracer = P_SnapshotPointer(mobj->tracer);
+		}
+	}
+
+	for (i = 0; i < numsectors; i++)
+	{
+		CopyBytes(data, &sectors[i], sizeof(sector_t));
+		sectors[i].soundtarget = P_SnapshotPointer(sectors[i].soundtarget);
+		sectors[i].thinglist = P_SnapshotPointer(sectors[i].thinglist);
+		sectors[i].specialdata = P_SnapshotPointer(sectors[i].specialdata);
+		data += sizeof(sector_t);
+	}
+
+	for (i = 0; i < numlines; i++)
+	{
+		CopyBytes(data, &lines[i], sizeof(line_t));
+		lines[i].specialdata = P_SnapshotPointer(lines[i].specialdata);
+		data += sizeof(line_t);
+	}
+
+	CopyBytes(data, sides, numsides * sizeof(side_t));
+	data += numsides * sizeof(side_t);
+
+	for (i = 0; i < blocks; i++)
+	{
+		blocklinks[i] = P_SnapshotPointer(((mobj_t **)data)[i]);
+	}
+
+	leveltime = snapshot->leveltime;
+	prndindex = snapshot->prndindex;
+	totalkills = snapshot->totalkills;
+	totalitems = snapshot->totalitems;
+	totalsecret = snapshot->totalsecret;
+
+	CopyBytes(&snapshot->players, &players, sizeof(player_t));
+	players.mo = P_SnapshotPointer(players.mo);
+	players.attacker = P_SnapshotPointer(players.attacker);
+	players_mo = P_SnapshotPointer(snapshot->players_mo);
+
+	for (i = 0; i < MAXCEILINGS; i++)
+		activeceilings[i] = P_SnapshotPointer(snapshot->activeceilings[i]);
+
+	for (i = 0; i < MAXPLATS; i++)
+		activeplats[i] = P_SnapshotPointer(snapshot->activeplats[i]);
+
+	CopyBytes(snapshot->buttonlist, buttonlist, sizeof(buttonlist));
+
+	for (i = 0; i < 32; i++)
+		braintargets[i] = P_SnapshotPointer(snapshot->braintargets[i]);
+
+	numbraintargets = snapshot->numbraintargets;
+	braintargeton = snapshot->braintargeton;
+
+	CopyBytes(snapshot->itemrespawnque, itemrespawnque, sizeof(itemrespawnque));
+	CopyBytes(snapshot->itemrespawntime, itemrespawntime, sizeof(itemrespawntime));
+	iquehead = snapshot->iquehead;
+	iquetail = snapshot->iquetail;
+
+	Z_Free(snaptable);
+
+	return true;
+}
+
+void P_FreeSnapshot(snapshot_t *snapshot)
+{
+	Z_Free(snapshot);
+}
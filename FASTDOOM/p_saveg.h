@@ -32,4 +32,11 @@ void P_UnArchiveSpecials(void);
 
 extern byte *save_p;
 
+// In-memory snapshot of the current level, restored in place
+typedef struct snapshot_s snapshot_t;
+
+snapshot_t *P_TakeSnapshot(void);
+boolean P_RestoreSnapshot(snapshot_t *snapshot);
+void P_FreeSnapshot(snapshot_t *snapshot);
+
 #endif
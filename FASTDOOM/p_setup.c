@@ -94,6 +94,14 @@ int *bmapwidthmuls;
 //
 byte *rejectmatrix;
 
+// Sector visibility table used as a PVS by the renderer, NULL if
+// there is none. Same layout as the reject matrix.
+byte *pvsmatrix;
+
+// Incremented by every P_SetupLevel, a reloaded level can come back at
+// the same addresses so pointers into it are only valid for one load
+int levelgeneration;
+
 //
 // P_LoadVertexes
 //
@@ -574,6 +582,7 @@ void P_SetupLevel(int episode,
     S_ClearSounds();
 
     Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
+    levelgeneration++;
 
     P_InitThinkers();
 
@@ -612,6 +621,13 @@ void P_SetupLevel(int episode,
     rejectmatrix = W_CacheLumpNum(lumpnum + ML_REJECT, PU_LEVEL);
     P_GroupLines();
 
+    pvsmatrix = NULL;
+
+    if (visparm || pvsparm)
+        P_LoadVisMatrix(lumpname, lumpnum + ML_REJECT);
+
+    R_SetupPVS();
+
     P_LoadThings(lumpnum + ML_THINGS);
 
     // clear special respawning que
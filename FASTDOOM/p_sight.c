@@ -16,17 +16,23 @@
 //	LineOfSight/Visibility checks, uses REJECT Lookup Table.
 //
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "options.h"
 #include "doomdef.h"
 
 #include "i_system.h"
+#include "z_zone.h"
+#include "w_wad.h"
 #include "p_local.h"
 
 // State.
+#include "doomstat.h"
 #include "r_state.h"
 
 #include "std_func.h"
+#include "fastmath.h"
 
 //
 // P_CheckSight
@@ -39,6 +45,34 @@ divline_t strace; // from t1 to t2
 fixed_t t2x;
 fixed_t t2y;
 
+//
+// Sight cache
+// BSP walk results indexed by subsector pair. An entry only hits
+// when every input of the walk is the same, so results are exact.
+// sightstamp changes every tic and whenever a plane moves, which
+// invalidates all entries at once.
+//
+#define SIGHTCACHE_SIZE 64
+
+typedef struct
+{
+    int stamp;
+    fixed_t x1;
+    fixed_t y1;
+    fixed_t z1; // eye z of looker
+    fixed_t x2;
+    fixed_t y2;
+    fixed_t z2;
+    fixed_t height2;
+    byte result;
+} sightcache_t;
+
+sightcache_t sightcache[SIGHTCACHE_SIZE];
+int sightstamp = 1;
+
+unsigned int sightchecks;
+unsigned int sighthits;
+
 //
 // P_CrossSubsector
 // Returns true
@@ -258,6 +292,7 @@ byte P_CheckSight(mobj_t *t1, mobj_t *t2)
     int pnum;
     int bytenum;
     int bitnum;
+    sightcache_t *cache;
 
     // First check for trivial rejection.
 
@@ -278,9 +313,21 @@ byte P_CheckSight(mobj_t *t1, mobj_t *t2)
     // An unobstructed LOS is possible.
     // Now look from eyes of t1 to any part of t2.
 
+    sightzstart = t1->z + t1->height - (t1->height >> 2);
+
+    sightchecks++;
+
+    cache = &sightcache[((t1->subsector - subsectors) * 7 + (t2->subsector - subsectors)) & (SIGHTCACHE_SIZE - 1)];
+
+    if (cache->stamp == sightstamp && cache->x1 == t1->x && cache->y1 == t1->y && cache->z1 == sightzstart &&
+        cache->x2 == t2->x && cache->y2 == t2->y && cache->z2 == t2->z && cache->height2 == t2->height)
+    {
+        sighthits++;
+        return cache->result;
+    }
+
     validcount++;
 
-    sightzstart = t1->z + t1->height - (t1->height >> 2);
     topslope = (t2->z + t2->height) - sightzstart;
     bottomslope = (t2->z) - sightzstart;
 
@@ -292,5 +339,1129 @@ byte P_CheckSight(mobj_t *t1, mobj_t *t2)
     strace.dy = t2y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode(firstnode);
+    cache->stamp = sightstamp;
+    cache->x1 = t1->x;
+    cache->y1 = t1->y;
+    cache->z1 = sightzstart;
+    cache->x2 = t2x;
+    cache->y2 = t2y;
+    cache->z2 = t2->z;
+    cache->height2 = t2->height;
+    cache->result = P_CrossBSPNode(firstnode);
+
+    return cache->result;
+}
+
+//
+// P_SightReport
+// Sight checks that reached the BSP walk and how many were cached
+//
+void P_SightReport(char *buffer)
+{
+    unsigned int total = sightchecks ? sightchecks : 1;
+
+    sprintf(buffer, "\nSight checks %u, cached %u (%u.%u%%)\n", sightchecks, sighthits,
+            sighthits * 100 / total, (sighthits * 1000 / total) % 10);
+}
+
+//
+// SECTOR VISIBILITY
+// Many node builders emit an empty REJECT. With -vis a conservative
+// sector to sector visibility table is built and the sector pairs
+// that can't see each other are added to the reject matrix, so
+// P_CheckSight skips them before the BSP walk.
+//
+// Sight lines are flowed through the portals of the map (two sided
+// lines between different sectors), clipped against the lines that
+// separate the source and pass portals. Heights are ignored, as doors
+// can open. Sight lines that graze a wall can slip through it, so thin
+// walls (one sided lines back to back) are portals too, and every pair
+// of sectors around a vertex not joined by a portal there is joined by
+// a small diamond. Sources that run out of steps fall back to every
+// sector connected to them.
+//
+// P_CheckSight only tests the lines that have segs. A line without segs
+// doesn't block anything, so it joins every sector found along it in
+// the BSP, in both directions. One sided lines without segs also join
+// the void behind them, an extra sector that sight lines cross to reach
+// the other lines without segs.
+//
+// The result is saved as <map>.VIS and reused while the map lines and
+// segs are unchanged. SCRIPTS/VisBuild builds the same files offline,
+// with the same fixed point arithmetic.
+//
+#define VIS_EPSILON (4 * FRACUNIT)
+#define VIS_TOLERANCE (FRACUNIT / 16)
+#define VIS_MAXDEPTH 64
+#define VIS_MAXSTEPS 65536
+#define VIS_MAXSEPARATORS 16
+#define VIS_VERSION 3
+
+typedef struct
+{
+    fixed_t nx;
+    fixed_t ny;
+    fixed_t d;
+} visline_t;
+
+typedef struct
+{
+    fixed_t x[4];
+    fixed_t y[4];
+    int numpoints; // 2 for line portals, 4 for vertex diamonds
+    int sector[2];
+    int vertex; // -1 for line portals
+    byte oriented; // sector[0] on the right of the line, else crossed both ways
+    visline_t line;
+    fixed_t slack; // VIS_TOLERANCE as a fraction of the portal
+} visportal_t;
+
+// Portal seen from one of its sectors
+typedef struct
+{
+    int portal;
+    int other;
+    byte hasplane;
+    visline_t plane; // sight lines are on its positive side after crossing
+} vislink_t;
+
+// Widest window flowed through from the current source portal
+typedef struct
+{
+    int stamp;
+    fixed_t t0;
+    fixed_t t1;
+} viswindow_t;
+
+typedef struct
+{
+    char magic[4];
+    int version;
+    int numsectors;
+    unsigned int hash;
+} visheader_t;
+
+visportal_t *visportals;
+int numvisportals;
+int *visfirst; // first link of every sector
+vislink_t *vislinks;
+viswindow_t *viswindows;
+int visstamp;
+int numvissectors; // numsectors and the void
+byte *vismatrix; // numvissectors * numvissectors bits, set if it may see
+byte *vislinesegs; // set for the lines with segs
+int vissource;
+int vissteps;
+byte visoverflow;
+
+#define VIS_MARK(a, b) vismatrix[((a) * numvissectors + (b)) >> 3] |= 1 << (((a) * numvissectors + (b)) & 7)
+#define VIS_CLEAR(a, b) vismatrix[((a) * numvissectors + (b)) >> 3] &= ~(1 << (((a) * numvissectors + (b)) & 7))
+#define VIS_TEST(a, b) (vismatrix[((a) * numvissectors + (b)) >> 3] & (1 << (((a) * numvissectors + (b)) & 7)))
+
+// Distance to the line, positive to the left
+#define P_VisSide(line, x, y) (FixedMul((line)->nx, (x)) + FixedMul((line)->ny, (y)) - (line)->d)
+
+//
+// P_VisLineSegs
+// Marks the lines that have segs
+//
+void P_VisLineSegs(void)
+{
+    int i, j;
+
+    vislinesegs = Z_MallocUnowned(numlines, PU_STATIC);
+    SetBytes(vislinesegs, 0, numlines);
+
+    for (i = 0; i < numsubsectors; i++)
+    {
+        for (j = 0; j < subsectors[i].numlines; j++)
+            vislinesegs[segs[subsectors[i].firstline + j].linedef - lines] = 1;
+    }
+}
+
+//
+// P_VisHash
+// Identifies the map geometry the table was built from
+//
+unsigned int P_VisHash(void)
+{
+    unsigned int hash = 2166136261u;
+    line_t *line;
+    int i;
+
+    hash = (hash ^ (unsigned int)numsectors) * 16777619u;
+    hash = (hash ^ (unsigned int)numlines) * 16777619u;
+    hash = (hash ^ (unsigned int)numsubsectors) * 16777619u;
+
+    for (i = 0, line = lines; i < numlines; i++, line++)
+    {
+        hash = (hash ^ (unsigned int)(line->v1->x >> FRACBITS)) * 16777619u;
+        hash = (hash ^ (unsigned int)(line->v1->y >> FRACBITS)) * 16777619u;
+        hash = (hash ^ (unsigned int)(line->v2->x >> FRACBITS)) * 16777619u;
+        hash = (hash ^ (unsigned int)(line->v2->y >> FRACBITS)) * 16777619u;
+        hash = (hash ^ (unsigned int)line->flags) * 16777619u;
+        hash = (hash ^ (unsigned int)(line->frontsector ? line->frontsector - sectors : -1)) * 16777619u;
+        hash = (hash ^ (unsigned int)(line->backsector ? line->backsector - sectors : -1)) * 16777619u;
+        hash = (hash ^ (unsigned int)vislinesegs[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+//
+// P_MakeVisLine
+// Line through (x1,y1)-(x2,y2), returns false if it is degenerate
+//
+byte P_MakeVisLine(visline_t *line, fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2)
+{
+    fixed_t dx = x2 - x1;
+    fixed_t dy = y2 - y1;
+    fixed_t len = P_AproxDistance(dx, dy);
+
+    if (len < VIS_TOLERANCE)
+        return 0;
+
+    line->nx = FixedDiv(-dy, len);
+    line->ny = FixedDiv(dx, len);
+    line->d = FixedMul(line->nx, x1) + FixedMul(line->ny, y1);
+
+    return 1;
+}
+
+//
+// P_AddVisLinePortal
+//
+byte P_AddVisLinePortal(line_t *line, int front, int back)
+{
+    visportal_t *portal = &visportals[numvisportals];
+
+    if (!P_MakeVisLine(&portal->line, line->v1->x, line->v1->y, line->v2->x, line->v2->y))
+        return 0;
+
+    portal->x[0] = line->v1->x;
+    portal->y[0] = line->v1->y;
+    portal->x[1] = line->v2->x;
+    portal->y[1] = line->v2->y;
+    portal->numpoints = 2;
+    portal->sector[0] = front;
+    portal->sector[1] = back;
+    portal->vertex = -1;
+    portal->oriented = 1;
+    portal->slack = FixedDiv(VIS_TOLERANCE, P_AproxDistance(line->dx, line->dy));
+
+    numvisportals++;
+
+    return 1;
+}
+
+//
+// P_MarkVisPair
+// Sectors joined by a portal at both ends of the line
+//
+void P_MarkVisPair(line_t *line, int front, int back, short *vertexsectors, int *vertexsectorfirst, int *vertexcount,
+                   byte *vertexpairs, int *vertexpairfirst)
+{
+    int a, b, j, k, v;
+    short *sectors;
+    byte *pairs;
+
+    for (k = 0; k < 2; k++)
+    {
+        v = (k ? line->v2 : line->v1) - vertexes;
+        sectors = vertexsectors + vertexsectorfirst[v];
+        pairs = vertexpairs + vertexpairfirst[v];
+        a = -1;
+        b = -1;
+
+        for (j = 0; j < vertexcount[v]; j++)
+        {
+            if (sectors[j] == front)
+                a = j;
+            if (sectors[j] == back)
+                b = j;
+        }
+
+        if (a != -1 && b != -1)
+        {
+            pairs[a * vertexcount[v] + b] = 1;
+            pairs[b * vertexcount[v] + a] = 1;
+        }
+    }
+}
+
+//
+// P_ThinWallSector
+// Sector behind a one sided line if an earlier one sided line runs
+// back to back with it, else -1
+//
+int P_ThinWallSector(int i, int *vertexfirst, int *vertexlines)
+{
+    line_t *line = &lines[i];
+    line_t *other = NULL;
+    int v = line->v2 - vertexes;
+    int k;
+
+    for (k = vertexfirst[v]; k < vertexfirst[v + 1]; k++)
+    {
+        line_t *check = &lines[vertexlines[k]];
+
+        if (vertexlines[k] < i && check->v2 == line->v1 && !((check->flags & ML_TWOSIDED) && check->backsector) &&
+            check->frontsector && (!other || check > other))
+            other = check;
+    }
+
+    if (!other || other->frontsector == line->frontsector)
+        return -1;
+
+    return other->frontsector - sectors;
+}
+
+//
+// P_VisNodeSide
+// Side of the partition a vertex is on, 2 if it is on the partition.
+// In map units scaled by 1/4, so the products can't overflow.
+//
+int P_VisNodeSide(node_t *node, vertex_t *vertex)
+{
+    fixed_t left = FixedMul(node->dys << 7, ((vertex->x >> FRACBITS) - node->xs) << 7);
+    fixed_t right = FixedMul(((vertex->y >> FRACBITS) - node->ys) << 7, node->dxs << 7);
+
+    if (abs(left - right) <= 1)
+        return 2;
+
+    return right >= left;
+}
+
+//
+// P_VisLineSectors
+// Adds the sector of every subsector the line runs through
+//
+int P_VisLineSectors(int bspnum, line_t *line, int *linesectors, int count, byte *marked)
+{
+    node_t *node;
+    int side1, side2;
+    int s;
+
+    if (bspnum & NF_SUBSECTOR)
+    {
+        s = subsectors[bspnum & ~NF_SUBSECTOR].sector - sectors;
+
+        if (!marked[s])
+        {
+            marked[s] = 1;
+            linesectors[count++] = s;
+        }
+
+        return count;
+    }
+
+    node = &nodes[bspnum];
+    side1 = P_VisNodeSide(node, line->v1);
+    side2 = P_VisNodeSide(node, line->v2);
+
+    if (side1 != 1 && side2 != 1)
+        count = P_VisLineSectors(node->children[0], line, linesectors, count, marked);
+
+    if (side1 != 0 && side2 != 0)
+        count = P_VisLineSectors(node->children[1], line, linesectors, count, marked);
+
+    return count;
+}
+
+//
+// P_VisSeglessSectors
+// Sectors a line without segs joins, its own sectors first
+//
+int P_VisSeglessSectors(line_t *line, int *linesectors, byte *marked)
+{
+    int count = 0;
+    int i;
+
+    if (line->frontsector)
+    {
+        linesectors[count++] = line->frontsector - sectors;
+        marked[line->frontsector - sectors] = 1;
+    }
+
+    if (line->backsector && !marked[line->backsector - sectors])
+    {
+        linesectors[count++] = line->backsector - sectors;
+        marked[line->backsector - sectors] = 1;
+    }
+
+    if (!line->backsector)
+    {
+        linesectors[count++] = numsectors;
+        marked[numsectors] = 1;
+    }
+
+    count = P_VisLineSectors(firstnode == -1 ? NF_SUBSECTOR : firstnode, line, linesectors, count, marked);
+
+    for (i = 0; i < count; i++)
+        marked[linesectors[i]] = 0;
+
+    return count;
+}
+
+//
+// P_BuildVisPortals
+//
+void P_BuildVisPortals(void)
+{
+    short *vertexsectors;
+    int *vertexsectorfirst;
+    int *vertexcount;
+    byte *vertexpairs;
+    int *vertexpairfirst;
+    int *vertexfirst;
+    int *vertexlines;
+    int *linesectors;
+    byte *marked;
+    line_t *line;
+    int i, j, k, v, s, count;
+    int maxportals;
+
+    // Every line end adds at most two sectors to its vertex
+    vertexsectors = Z_MallocUnowned(numlines * 4 * sizeof(short), PU_STATIC);
+    vertexsectorfirst = Z_MallocUnowned((numvertexes + 1) * sizeof(int), PU_STATIC);
+    vertexcount = Z_MallocUnowned(numvertexes * sizeof(int), PU_STATIC);
+    vertexpairfirst = Z_MallocUnowned((numvertexes + 1) * sizeof(int), PU_STATIC);
+    vertexfirst = Z_MallocUnowned((numvertexes + 1) * sizeof(int), PU_STATIC);
+    vertexlines = Z_MallocUnowned(numlines * sizeof(int), PU_STATIC);
+    linesectors = Z_MallocUnowned(numvissectors * sizeof(int), PU_STATIC);
+    marked = Z_MallocUnowned(numvissectors, PU_STATIC);
+    SetBytes(marked, 0, numvissectors);
+    SetDWords(vertexsectorfirst, 0, numvertexes + 1);
+    SetDWords(vertexcount, 0, numvertexes);
+    SetDWords(vertexfirst, 0, numvertexes + 1);
+
+    for (i = 0, line = lines; i < numlines; i++, line++)
+    {
+        vertexsectorfirst[line->v1 - vertexes + 1] += 2;
+        vertexsectorfirst[line->v2 - vertexes + 1] += 2;
+    }
+
+    for (v = 0; v < numvertexes; v++)
+        vertexsectorfirst[v + 1] += vertexsectorfirst[v];
+
+    // Sectors around every vertex, lines starting at every vertex
+    for (i = 0, line = lines; i < numlines; i++, line++)
+    {
+        for (k = 0; k < 4; k++)
+        {
+            sector_t *sector = (k & 1) ? line->backsector : line->frontsector;
+
+            if (!sector)
+                continue;
+
+            v = ((k & 2) ? line->v2 : line->v1) - vertexes;
+            s = sector - sectors;
+
+            for (j = 0; j < vertexcount[v]; j++)
+            {
+                if (vertexsectors[vertexsectorfirst[v] + j] == s)
+                    break;
+            }
+
+            if (j == vertexcount[v])
+            {
+                vertexsectors[vertexsectorfirst[v] + j] = s;
+                vertexcount[v]++;
+            }
+        }
+
+        vertexfirst[line->v1 - vertexes + 1]++;
+    }
+
+    for (v = 0; v < numvertexes; v++)
+        vertexfirst[v + 1] += vertexfirst[v];
+
+    for (i = 0, line = lines; i < numlines; i++, line++)
+        vertexlines[vertexfirst[line->v1 - vertexes]++] = i;
+
+    for (v = numvertexes; v > 0; v--)
+        vertexfirst[v] = vertexfirst[v - 1];
+
+    vertexfirst[0] = 0;
+
+    // Sector pairs already joined by a line portal at every vertex
+    vertexpairfirst[0] = 0;
+
+    for (v = 0; v < numvertexes; v++)
+        vertexpairfirst[v + 1] = vertexpairfirst[v] + vertexcount[v] * vertexcount[v];
+
+    vertexpairs = Z_MallocUnowned(vertexpairfirst[numvertexes], PU_STATIC);
+    SetBytes(vertexpairs, 0, vertexpairfirst[numvertexes]);
+
+    maxportals = numlines;
+
+    for (v = 0; v < numvertexes; v++)
+    {
+        count = vertexcount[v];
+        maxportals += count * (count - 1) / 2;
+    }
+
+    for (i = 0, line = lines; i < numlines; i++, line++)
+    {
+        if (!vislinesegs[i])
+        {
+            count = P_VisSeglessSectors(line, linesectors, marked);
+            maxportals += count * (count - 1) / 2;
+        }
+    }
+
+    visportals = Z_MallocUnowned(maxportals * sizeof(visportal_t), PU_STATIC);
+    numvisportals = 0;
+
+    // Two sided lines and thin walls
+    for (i = 0, line = lines; i < numlines; i++, line++)
+    {
+        int front, back;
+
+        if (!vislinesegs[i])
+        {
+            // Sight lines cross it between any of the sectors along it,
+            // which side each one is on isn't known
+            count = P_VisSeglessSectors(line, linesectors, marked);
+
+            for (j = 0; j < count; j++)
+            {
+                for (k = j + 1; k < count; k++)
+                {
+                    if (!P_AddVisLinePortal(line, linesectors[j], linesectors[k]))
+                        continue;
+
+                    visportals[numvisportals - 1].oriented = 0;
+                    P_MarkVisPair(line, linesectors[j], linesectors[k], vertexsectors, vertexsectorfirst, vertexcount,
+                                  vertexpairs, vertexpairfirst);
+                }
+            }
+
+            continue;
+        }
+
+        if ((line->flags & ML_TWOSIDED) && line->backsector)
+        {
+            if (!line->frontsector || line->frontsector == line->backsector)
+                continue;
+
+            front = line->frontsector - sectors;
+            back = line->backsector - sectors;
+        }
+        else
+        {
+            // Sight lines grazing a thin wall can slip through it at
+            // any point
+            if (!line->frontsector)
+                continue;
+
+            front = line->frontsector - sectors;
+            back = P_ThinWallSector(i, vertexfirst, vertexlines);
+
+            if (back == -1)
+                continue;
+        }
+
+        if (P_AddVisLinePortal(line, front, back))
+            P_MarkVisPair(line, front, back, vertexsectors, vertexsectorfirst, vertexcount, vertexpairs,
+                          vertexpairfirst);
+    }
+
+    // Diamonds around vertexes
+    for (v = 0; v < numvertexes; v++)
+    {
+        fixed_t x = vertexes[v].x;
+        fixed_t y = vertexes[v].y;
+        short *vsectors = vertexsectors + vertexsectorfirst[v];
+        byte *pairs = vertexpairs + vertexpairfirst[v];
+
+        count = vertexcount[v];
+
+        for (i = 0; i < count; i++)
+        {
+            for (j = i + 1; j < count; j++)
+            {
+                visportal_t *portal;
+
+                if (pairs[i * count + j])
+                    continue;
+
+                portal = &visportals[numvisportals++];
+                portal->x[0] = x - VIS_EPSILON;
+                portal->y[0] = y;
+                portal->x[1] = x;
+                portal->y[1] = y - VIS_EPSILON;
+                portal->x[2] = x + VIS_EPSILON;
+                portal->y[2] = y;
+                portal->x[3] = x;
+                portal->y[3] = y + VIS_EPSILON;
+                portal->numpoints = 4;
+                portal->sector[0] = vsectors[i];
+                portal->sector[1] = vsectors[j];
+                portal->vertex = v;
+                portal->oriented = 0;
+                portal->slack = 0;
+            }
+        }
+    }
+
+    Z_Free(vertexsectors);
+    Z_Free(vertexsectorfirst);
+    Z_Free(vertexcount);
+    Z_Free(vertexpairs);
+    Z_Free(vertexpairfirst);
+    Z_Free(vertexfirst);
+    Z_Free(vertexlines);
+    Z_Free(linesectors);
+    Z_Free(marked);
+
+    // Links of every sector, the front sector is on the right of a line
+    visfirst = Z_MallocUnowned((numvissectors + 1) * sizeof(int), PU_STATIC);
+    vislinks = Z_MallocUnowned(numvisportals * 2 * sizeof(vislink_t), PU_STATIC);
+    viswindows = Z_MallocUnowned(numvisportals * 2 * sizeof(viswindow_t), PU_STATIC);
+    SetDWords(visfirst, 0, numvissectors + 1);
+    SetBytes(viswindows, 0, numvisportals * 2 * sizeof(viswindow_t));
+    visstamp = 0;
+
+    for (i = 0; i < numvisportals; i++)
+    {
+        visfirst[visportals[i].sector[0] + 1]++;
+        visfirst[visportals[i].sector[1] + 1]++;
+    }
+
+    for (s = 0; s < numvissectors; s++)
+        visfirst[s + 1] += visfirst[s];
+
+    for (i = 0; i < numvisportals; i++)
+    {
+        visportal_t *portal = &visportals[i];
+
+        for (k = 0; k < 2; k++)
+        {
+            vislink_t *link = &vislinks[visfirst[portal->sector[k]]++];
+
+            link->portal = i;
+            link->other = portal->sector[k ^ 1];
+            link->hasplane = portal->oriented;
+            link->plane = portal->line;
+
+            if (k)
+            {
+                link->plane.nx = -link->plane.nx;
+                link->plane.ny = -link->plane.ny;
+                link->plane.d = -link->plane.d;
+            }
+        }
+    }
+
+    for (s = numvissectors; s > 0; s--)
+        visfirst[s] = visfirst[s - 1];
+
+    visfirst[0] = 0;
+}
+
+//
+// P_VisSeparator
+// Line through a point of the source and a point of the pass window
+// with all the source on one side and all the window on the other,
+// oriented with the window on the positive side
+//
+byte P_VisSeparator(visline_t *line, fixed_t sx, fixed_t sy, fixed_t px, fixed_t py, fixed_t *source, int numsource, fixed_t *window, int numwindow)
+{
+    fixed_t mins = MAXINT, maxs = MININT;
+    fixed_t minp = MAXINT, maxp = MININT;
+    fixed_t d;
+    int i;
+
+    if (!P_MakeVisLine(line, sx, sy, px, py))
+        return 0;
+
+    for (i = 0; i < numsource; i++)
+    {
+        d = P_VisSide(line, source[i * 2], source[i * 2 + 1]);
+        if (d < mins)
+            mins = d;
+        if (d > maxs)
+            maxs = d;
+    }
+
+    for (i = 0; i < numwindow; i++)
+    {
+        d = P_VisSide(line, window[i * 2], window[i * 2 + 1]);
+        if (d < minp)
+            minp = d;
+        if (d > maxp)
+            maxp = d;
+    }
+
+    if (maxs <= VIS_TOLERANCE && minp >= -VIS_TOLERANCE && mins < -VIS_TOLERANCE && maxp > VIS_TOLERANCE)
+        return 1;
+
+    if (mins >= -VIS_TOLERANCE && maxp <= VIS_TOLERANCE && maxs > VIS_TOLERANCE && minp < -VIS_TOLERANCE)
+    {
+        line->nx = -line->nx;
+        line->ny = -line->ny;
+        line->d = -line->d;
+        return 1;
+    }
+
+    return 0;
+}
+
+//
+// P_VisBehind
+// Sight lines cross a portal coming from the near side, so the source
+// and the pass window can't be completely past it
+//
+byte P_VisBehind(vislink_t *link, fixed_t *points, int numpoints)
+{
+    int i;
+
+    if (!link->hasplane)
+        return 0;
+
+    for (i = 0; i < numpoints; i++)
+    {
+        if (P_VisSide(&link->plane, points[i * 2], points[i * 2 + 1]) <= VIS_TOLERANCE)
+            return 0;
+    }
+
+    return 1;
+}
+
+//
+// P_VisSkip
+// Portals a sight line can't cross right after the pass portal. A
+// portal lying on the pass portal line can only be crossed where both
+// meet, at a vertex, and the area around a vertex is crossed once, by
+// the diamond between both sectors
+//
+byte P_VisSkip(visportal_t *portal, visportal_t *pass)
+{
+    if (portal == pass)
+        return 1;
+
+    if (pass->vertex != -1)
+        return portal->vertex == pass->vertex;
+
+    if (portal->vertex != -1)
+        return 0;
+
+    return abs(P_VisSide(&pass->line, portal->x[0], portal->y[0])) <= VIS_TOLERANCE &&
+           abs(P_VisSide(&pass->line, portal->x[1], portal->y[1])) <= VIS_TOLERANCE;
+}
+
+//
+// P_VisClip
+// Clips a portal to the inner side of every plane, diamonds are never
+// clipped. Returns false if nothing is left
+//
+byte P_VisClip(visportal_t *portal, visline_t *planes, int numplanes, fixed_t *t0, fixed_t *t1)
+{
+    int i, k;
+
+    *t0 = 0;
+    *t1 = FRACUNIT;
+
+    if (portal->vertex != -1)
+    {
+        for (i = 0; i < numplanes; i++)
+        {
+            for (k = 0; k < 4; k++)
+            {
+                if (P_VisSide(&planes[i], portal->x[k], portal->y[k]) >= -VIS_TOLERANCE)
+                    break;
+            }
+
+            if (k == 4)
+                return 0;
+        }
+
+        return 1;
+    }
+
+    for (i = 0; i < numplanes; i++)
+    {
+        fixed_t d0 = P_VisSide(&planes[i], portal->x[0], portal->y[0]) + VIS_TOLERANCE;
+        fixed_t d1 = P_VisSide(&planes[i], portal->x[1], portal->y[1]) + VIS_TOLERANCE;
+
+        if (d0 < 0 && d1 < 0)
+            return 0;
+
+        if (d0 < 0)
+        {
+            fixed_t t = FixedDiv(d0, d0 - d1);
+            if (t > *t0)
+                *t0 = t;
+        }
+        else if (d1 < 0)
+        {
+            fixed_t t = FixedDiv(d0, d0 - d1);
+            if (t < *t1)
+                *t1 = t;
+        }
+
+        if (*t0 > *t1)
+            return 0;
+    }
+
+    return 1;
+}
+
+//
+// P_VisWindow
+// Points of the clipped portal, returns how many
+//
+int P_VisWindow(visportal_t *portal, fixed_t t0, fixed_t t1, fixed_t *window)
+{
+    int i;
+
+    if (portal->vertex != -1)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            window[i * 2] = portal->x[i];
+            window[i * 2 + 1] = portal->y[i];
+        }
+
+        return 4;
+    }
+
+    window[0] = portal->x[0] + FixedMul(portal->x[1] - portal->x[0], t0);
+    window[1] = portal->y[0] + FixedMul(portal->y[1] - portal->y[0], t0);
+    window[2] = portal->x[0] + FixedMul(portal->x[1] - portal->x[0], t1);
+    window[3] = portal->y[0] + FixedMul(portal->y[1] - portal->y[0], t1);
+
+    return 2;
+}
+
+//
+// P_VisExplored
+// What is seen through a portal only depends on the source portal and
+// the window, so windows inside one already flowed through from the
+// same source portal can't reach anything new. This also ends loops.
+//
+byte P_VisExplored(int link, fixed_t t0, fixed_t t1)
+{
+    viswindow_t *previous = &viswindows[link];
+    fixed_t slack = visportals[vislinks[link].portal].slack;
+
+    if (previous->stamp == visstamp)
+    {
+        if (previous->t0 <= t0 + slack && t1 <= previous->t1 + slack)
+            return 1;
+
+        if (t1 - t0 <= previous->t1 - previous->t0)
+            return 0;
+    }
+
+    previous->stamp = visstamp;
+    previous->t0 = t0;
+    previous->t1 = t1;
+
+    return 0;
+}
+
+//
+// P_VisFlow
+// Looks through the links of a sector for sight lines that also cross
+// the source portal and the window of the pass portal
+//
+void P_VisFlow(fixed_t *source, int numsource, visline_t *sourceplane, visportal_t *pass, fixed_t *window, int numwindow, visline_t *passplane, int sector, int depth)
+{
+    visline_t planes[2 + VIS_MAXSEPARATORS];
+    fixed_t target[8];
+    int numplanes = 0;
+    int i, j, k;
+
+    // Sight lines stay past the source and pass portal lines
+    if (sourceplane)
+        planes[numplanes++] = *sourceplane;
+
+    if (passplane)
+        planes[numplanes++] = *passplane;
+
+    for (i = 0; i < numsource; i++)
+    {
+        for (j = 0; j < numwindow && numplanes < 2 + VIS_MAXSEPARATORS; j++)
+        {
+            if (P_VisSeparator(&planes[numplanes], source[i * 2], source[i * 2 + 1], window[j * 2], window[j * 2 + 1],
+                               source, numsource, window, numwindow))
+                numplanes++;
+        }
+    }
+
+    for (k = visfirst[sector]; k < visfirst[sector + 1]; k++)
+    {
+        vislink_t *link = &vislinks[k];
+        visportal_t *portal = &visportals[link->portal];
+        fixed_t t0, t1;
+        int numtarget;
+
+        if (P_VisSkip(portal, pass) || P_VisBehind(link, source, numsource) || P_VisBehind(link, window, numwindow))
+            continue;
+
+        if (++vissteps > VIS_MAXSTEPS)
+        {
+            visoverflow = 1;
+            return;
+        }
+
+        if (!P_VisClip(portal, planes, numplanes, &t0, &t1))
+            continue;
+
+        VIS_MARK(vissource, link->other);
+
+        if (P_VisExplored(k, t0, t1))
+            continue;
+
+        if (depth == VIS_MAXDEPTH)
+        {
+            visoverflow = 1;
+            return;
+        }
+
+        numtarget = P_VisWindow(portal, t0, t1, target);
+        P_VisFlow(source, numsource, sourceplane, portal, target, numtarget, link->hasplane ? &link->plane : NULL, link->other, depth + 1);
+
+        if (visoverflow)
+            return;
+    }
+}
+
+//
+// P_VisConnected
+// Fallback, every sector reachable through portals
+//
+void P_VisConnected(int *stack)
+{
+    int sp = 0;
+    int k;
+
+    for (k = 0; k < numvissectors; k++)
+        VIS_CLEAR(vissource, k);
+
+    VIS_MARK(vissource, vissource);
+    stack[sp++] = vissource;
+
+    while (sp)
+    {
+        int sector = stack[--sp];
+
+        for (k = visfirst[sector]; k < visfirst[sector + 1]; k++)
+        {
+            int other = vislinks[k].other;
+
+            if (!VIS_TEST(vissource, other))
+            {
+                VIS_MARK(vissource, other);
+                stack[sp++] = other;
+            }
+        }
+    }
+}
+
+//
+// P_VisSector
+// Sectors seen from vissource
+//
+void P_VisSector(void)
+{
+    fixed_t source[8];
+    fixed_t window[8];
+    int j, k, i;
+
+    VIS_MARK(vissource, vissource);
+    vissteps = 0;
+    visoverflow = 0;
+
+    for (j = visfirst[vissource]; j < visfirst[vissource + 1]; j++)
+    {
+        vislink_t *link1 = &vislinks[j];
+        visportal_t *portal1 = &visportals[link1->portal];
+        int sector1 = link1->other;
+
+        VIS_MARK(vissource, sector1);
+        visstamp++;
+
+        for (i = 0; i < portal1->numpoints; i++)
+        {
+            source[i * 2] = portal1->x[i];
+            source[i * 2 + 1] = portal1->y[i];
+        }
+
+        // Any line crossing two portals exists
+        for (k = visfirst[sector1]; k < visfirst[sector1 + 1]; k++)
+        {
+            vislink_t *link2 = &vislinks[k];
+            visportal_t *portal2 = &visportals[link2->portal];
+            fixed_t t0, t1;
+            int numwindow;
+
+            if (P_VisSkip(portal2, portal1) || P_VisBehind(link2, source, portal1->numpoints))
+                continue;
+
+            if (!P_VisClip(portal2, &link1->plane, link1->hasplane, &t0, &t1))
+                continue;
+
+            VIS_MARK(vissource, link2->other);
+
+            if (P_VisExplored(k, t0, t1))
+                continue;
+
+            numwindow = P_VisWindow(portal2, t0, t1, window);
+            P_VisFlow(source, portal1->numpoints, link1->hasplane ? &link1->plane : NULL, portal2, window, numwindow,
+                      link2->hasplane ? &link2->plane : NULL, link2->other, 2);
+
+            if (visoverflow)
+                return;
+        }
+    }
+}
+
+//
+// P_BuildVisMatrix
+// Returns the sector pairs that can't see each other, in REJECT layout
+//
+byte *P_BuildVisMatrix(int size)
+{
+    byte *reject;
+    int *stack;
+    int vissize;
+    int a, b;
+
+    numvissectors = numsectors + 1;
+    vissize = (numvissectors * numvissectors + 7) >> 3;
+
+    P_BuildVisPortals();
+
+    vismatrix = Z_MallocUnowned(vissize, PU_STATIC);
+    stack = Z_MallocUnowned(numvissectors * sizeof(int), PU_STATIC);
+    SetBytes(vismatrix, 0, vissize);
+
+    for (vissource = 0; vissource < numsectors; vissource++)
+    {
+        P_VisSector();
+
+        if (visoverflow)
+            P_VisConnected(stack);
+    }
+
+    // Sight is symmetric, only reject pairs hidden both ways
+    reject = Z_MallocUnowned(size, PU_STATIC);
+    SetBytes(reject, 0, size);
+
+    for (a = 0; a < numsectors; a++)
+    {
+        for (b = 0; b < numsectors; b++)
+        {
+            if (!VIS_TEST(a, b) && !VIS_TEST(b, a))
+                reject[(a * numsectors + b) >> 3] |= 1 << ((a * numsectors + b) & 7);
+        }
+    }
+
+    Z_Free(stack);
+    Z_Free(vismatrix);
+    Z_Free(viswindows);
+    Z_Free(vislinks);
+    Z_Free(visfirst);
+    Z_Free(visportals);
+
+    return reject;
+}
+
+//
+// P_LoadVisMatrix
+// Loads the sector visibility table of the map from <map>.VIS, with
+// -vis it is built and saved if missing and added to the reject
+// matrix. With -pvs it is kept for the renderer.
+//
+void P_LoadVisMatrix(char *mapname, int rejectlump)
+{
+    char filename[14];
+    visheader_t header;
+    byte *reject;
+    byte *matrix;
+    FILE *file;
+    int size = (numsectors * numsectors + 7) >> 3;
+    int length = W_LumpLength(rejectlump);
+    unsigned int hash;
+    int i;
+
+    P_VisLineSegs();
+    hash = P_VisHash();
+
+    sprintf(filename, "%s.VIS", mapname);
+
+    reject = NULL;
+    file = fopen(filename, "rb");
+
+    if (file)
+    {
+        if (fread(&header, sizeof(header), 1, file) == 1 && !strncmp(header.magic, "FDVS", 4) &&
+            header.version == VIS_VERSION && header.numsectors == numsectors && header.hash == hash)
+        {
+            reject = Z_MallocUnowned(size, PU_STATIC);
+
+            if (fread(reject, size, 1, file) != 1)
+            {
+                Z_Free(reject);
+                reject = NULL;
+            }
+        }
+
+        fclose(file);
+    }
+
+    if (!reject)
+    {
+        // Without -vis only prebuilt tables are used
+        if (!visparm)
+        {
+            Z_Free(vislinesegs);
+            return;
+        }
+
+        reject = P_BuildVisMatrix(size);
+
+        file = fopen(filename, "wb");
+
+        if (file)
+        {
+            header.magic[0] = 'F';
+            header.magic[1] = 'D';
+            header.magic[2] = 'V';
+            header.magic[3] = 'S';
+            header.version = VIS_VERSION;
+            header.numsectors = numsectors;
+            header.hash = hash;
+
+            fwrite(&header, sizeof(header), 1, file);
+            fwrite(reject, size, 1, file);
+            fclose(file);
+        }
+    }
+
+    if (visparm)
+    {
+        matrix = Z_MallocUnowned(size, PU_LEVEL);
+        SetBytes(matrix, 0, size);
+        CopyBytes(rejectmatrix, matrix, length < size ? length : size);
+        rejectmatrix = matrix;
+
+        for (i = 0; i < size; i++)
+            matrix[i] |= reject[i];
+    }
+
+    if (pvsparm)
+    {
+        Z_ChangeTag(reject, PU_LEVEL);
+        pvsmatrix = reject;
+    }
+    else
+    {
+        Z_Free(reject);
+    }
+
+    Z_Free(vislinesegs);
 }
@@ -17,10 +17,13 @@
 //	Thinker, Ticker.
 //
 
+#include <stdio.h>
+
 #include "z_zone.h"
 #include "p_local.h"
 #include "options.h"
 #include "doomstat.h"
+#include "p_tick.h"
 
 int leveltime;
 
@@ -35,12 +38,62 @@ int leveltime;
 // Both the head and tail of the thinker list.
 thinker_t thinkercap;
 
+// Mobjs with P_MobjTicklessThinker (static decorations and items) are
+// kept in their own list, so the tic loop never visits them. Every
+// thinker that runs stays in thinkercap, as the order they run in
+// decides the order of the P_Random calls and demos depend on it.
+// Removing a tickless mobj moves it to thinkercap, where it is freed.
+thinker_t ticklesscap;
+
 //
 // P_InitThinkers
 //
 void P_InitThinkers(void)
 {
     thinkercap.prev = thinkercap.next = &thinkercap;
+    ticklesscap.prev = ticklesscap.next = &ticklesscap;
+}
+
+//
+// Thinker class timing for -timedemo -nodraw.
+// I_TimerMS adds a sample to the running class every millisecond.
+//
+int thinkerclass = THINKER_OTHER;
+unsigned int thinkersamples[NUMTHINKERCLASSES];
+unsigned int thinkercalls[NUMTHINKERCLASSES];
+
+const char *thinkerclassnames[NUMTHINKERCLASSES] = {
+    "Rest of tic",
+    "Player",
+    "Mobjs",
+    "Brainless mobjs",
+    "Ceilings",
+    "Doors",
+    "Floors",
+    "Platforms",
+    "Lights",
+    "Unknown",
+    "Specials"};
+
+int P_ThinkerClass(actionf_p1 function)
+{
+    if (function == (actionf_p1)P_MobjThinker)
+        return THINKER_MOBJ;
+    if (function == (actionf_p1)P_MobjBrainlessThinker)
+        return THINKER_BRAINLESS;
+    if (function == (actionf_p1)T_MoveCeiling)
+        return THINKER_CEILING;
+    if (function == (actionf_p1)T_VerticalDoor)
+        return THINKER_DOOR;
+    if (function == (actionf_p1)T_MoveFloor)
+        return THINKER_FLOOR;
+    if (function == (actionf_p1)T_PlatRaise)
+        return THINKER_PLAT;
+    if (function == (actionf_p1)T_LightFlash || function == (actionf_p1)T_StrobeFlash ||
+        function == (actionf_p1)T_Glow || function == (actionf_p1)T_FireFlicker)
+        return THINKER_LIGHT;
+
+    return THINKER_UNKNOWN;
 }
 
 //
@@ -62,18 +115,78 @@ void P_RunThinkers(void)
             currentthinker = currentthinker->next;
             continue;
         }
-        else if (currentthinker->function.acp1 == 0 || currentthinker->function.acp1 == (actionf_p1)P_MobjTicklessThinker)
+        else if (currentthinker->function.acp1 == 0)
+        {
+            currentthinker = currentthinker->next;
+            continue;
+        }
+
+        currentthinker->function.acp1(currentthinker);
+
+        currentthinker = currentthinker->next;
+    }
+}
+
+//
+// P_RunThinkersTimed
+// Same as P_RunThinkers, tags the class of the running thinker
+// for -timedemo -nodraw
+//
+void P_RunThinkersTimed(void)
+{
+    thinker_t *currentthinker;
+
+    currentthinker = thinkercap.next;
+    while (currentthinker != &thinkercap)
+    {
+        if (currentthinker->function.acv == (actionf_v)(-1))
+        {
+            // time to remove it
+            currentthinker->next->prev = currentthinker->prev;
+            currentthinker->prev->next = currentthinker->next;
+            Z_Free(currentthinker);
+            currentthinker = currentthinker->next;
+            continue;
+        }
+        else if (currentthinker->function.acp1 == 0)
         {
             currentthinker = currentthinker->next;
             continue;
         }
 
+        thinkerclass = P_ThinkerClass(currentthinker->function.acp1);
+        thinkercalls[thinkerclass]++;
+
         currentthinker->function.acp1(currentthinker);
 
         currentthinker = currentthinker->next;
     }
 }
 
+//
+// P_ThinkerReport
+// Calls and sampled milliseconds per thinker class
+//
+void P_ThinkerReport(char *buffer)
+{
+    unsigned int total = 0;
+    int i;
+
+    for (i = 0; i < NUMTHINKERCLASSES; i++)
+        total += thinkersamples[i];
+
+    if (!total)
+        total = 1;
+
+    buffer += sprintf(buffer, "Class            Calls       ms      %%\n");
+
+    for (i = 0; i < NUMTHINKERCLASSES; i++)
+    {
+        buffer += sprintf(buffer, "%-15s %6u %8u %3u.%u\n", thinkerclassnames[i], thinkercalls[i], thinkersamples[i],
+                          thinkersamples[i] * 100 / total, (thinkersamples[i] * 1000 / total) % 10);
+    }
+}
+
 //
 // P_Ticker
 //
@@ -86,11 +199,33 @@ void P_Ticker(void)
     if (paused || (menuactive && !demoplayback && players.viewz != 1))
         return;
 
+    // New tic, forget cached sight checks
+    sightstamp++;
+
+    if (nodrawers)
+    {
+        thinkerclass = THINKER_PLAYER;
+        thinkercalls[THINKER_PLAYER]++;
+    }
+
     P_PlayerThink();
 
-    P_RunThinkers();
+    if (nodrawers)
+        P_RunThinkersTimed();
+    else
+        P_RunThinkers();
+
+    if (nodrawers)
+    {
+        thinkerclass = THINKER_SPECIALS;
+        thinkercalls[THINKER_SPECIALS]++;
+    }
+
     P_UpdateSpecials();
 
+    if (nodrawers)
+        thinkerclass = THINKER_OTHER;
+
     // for par times
     leveltime++;
 }
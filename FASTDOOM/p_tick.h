@@ -24,4 +24,29 @@
 // Carries out all thinking of monsters and players.
 void P_Ticker(void);
 
+//
+// Thinker classes, sampled by the 1 kHz timer in -timedemo -nodraw
+//
+enum
+{
+    THINKER_OTHER,    // Outside P_Ticker
+    THINKER_PLAYER,
+    THINKER_MOBJ,
+    THINKER_BRAINLESS,
+    THINKER_CEILING,
+    THINKER_DOOR,
+    THINKER_FLOOR,
+    THINKER_PLAT,
+    THINKER_LIGHT,
+    THINKER_UNKNOWN,
+    THINKER_SPECIALS, // P_UpdateSpecials
+    NUMTHINKERCLASSES
+};
+
+extern int thinkerclass;
+extern unsigned int thinkersamples[NUMTHINKERCLASSES];
+extern unsigned int thinkercalls[NUMTHINKERCLASSES];
+
+void P_ThinkerReport(char *buffer);
+
 #endif
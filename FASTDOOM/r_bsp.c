@@ -23,6 +23,7 @@
 #include "m_misc.h"
 
 #include "i_system.h"
+#include "z_zone.h"
 
 #include "r_main.h"
 #include "r_plane.h"
@@ -240,6 +241,8 @@ void R_AddLine(seg_t *line)
 
     curline = line;
 
+    RSTATS_ADD(segs, 1);
+
     // OPTIMIZE: quickly reject orthogonal back sides.
     angle1 = R_PointToAngle(line->v1->x, line->v1->y);
     angle2 = R_PointToAngle(line->v2->x, line->v2->y);
@@ -479,7 +482,63 @@ void R_Subsector(int num)
 //  traversing subtree recursively.
 // Just call with BSP root.
 
+//
+// PVS
+// With -pvs the sector visibility table culls the subtrees that
+// can't be seen from the view sector. Every node keeps a bit per
+// child, set if the child has a subsector in a visible sector.
+// Culled subtrees are still walked where R_CheckBBox passes, but only
+// their sprites are added, as a thing near the edge of a hidden sector
+// can reach into view.
+//
 #define MAX_BSP_DEPTH 64
+#define PVS_NONE (MAX_BSP_DEPTH + 1)
+
+byte *pvsnodes;
+int pvssector;
+
+void R_SetupPVS(void)
+{
+    pvssector = -1;
+
+    if (pvsmatrix && firstnode >= 0)
+        pvsnodes = Z_MallocUnowned(firstnode + 1, PU_LEVEL);
+    else
+        pvsnodes = NULL;
+}
+
+byte R_MarkPVSNode(int bspnum)
+{
+    byte bits;
+
+    if (bspnum & NF_SUBSECTOR)
+    {
+        int pnum = pvssector * numsectors + (subsectors[bspnum & ~NF_SUBSECTOR].sector - sectors);
+
+        return !(pvsmatrix[pnum >> 3] & (1 << (pnum & 7)));
+    }
+
+    bits = R_MarkPVSNode(nodes[bspnum].children[0]);
+    bits |= R_MarkPVSNode(nodes[bspnum].children[1]) << 1;
+    pvsnodes[bspnum] = bits;
+
+    return bits != 0;
+}
+
+//
+// R_UpdatePVS
+// Marks the nodes again when the view moves to another sector
+//
+void R_UpdatePVS(void)
+{
+    int sector = R_PointInSubsector(viewx, viewy)->sector - sectors;
+
+    if (sector != pvssector)
+    {
+        pvssector = sector;
+        R_MarkPVSNode(firstnode);
+    }
+}
 
 void R_RenderBSPNode(int bspnum)
 {
@@ -487,6 +546,7 @@ void R_RenderBSPNode(int bspnum)
     int stack_bsp[MAX_BSP_DEPTH];
     byte stack_side[MAX_BSP_DEPTH];
     byte sp = 0;
+    byte culled = PVS_NONE; // subtrees from this depth down are culled by the PVS
 
     while (true)
     {
@@ -523,10 +583,15 @@ void R_RenderBSPNode(int bspnum)
 
             sp++;
 
+            if (pvsnodes && culled == PVS_NONE && !(pvsnodes[bspnum] & (1 << side)))
+                culled = sp;
+
             bspnum = bsp->children[side];
         }
 
-        if (bspnum == -1)
+        if (culled <= sp)
+            R_AddSprites(subsectors[bspnum == -1 ? 0 : bspnum & (~NF_SUBSECTOR)].sector);
+        else if (bspnum == -1)
             R_Subsector(0);
         else
             R_Subsector(bspnum & (~NF_SUBSECTOR));
@@ -561,6 +626,12 @@ void R_RenderBSPNode(int bspnum)
             bsp = &nodes[stack_bsp[sp]];
         }
 
+        if (culled > sp)
+            culled = PVS_NONE;
+
+        if (pvsnodes && culled == PVS_NONE && !(pvsnodes[stack_bsp[sp]] & (1 << stack_side[sp])))
+            culled = sp;
+
         bspnum = bsp->children[stack_side[sp]];
     }
 }
@@ -36,4 +36,10 @@ void R_ClearDrawSegs(void);
 
 void R_RenderBSPNode(int bspnum);
 
+// PVS
+extern byte *pvsnodes;
+
+void R_SetupPVS(void);
+void R_UpdatePVS(void);
+
 #endif
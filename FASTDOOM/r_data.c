@@ -37,6 +37,7 @@
 #include <alloca.h>
 
 #include "r_data.h"
+#include "i_log.h"
 
 //
 // Graphics.
@@ -219,6 +220,8 @@ void R_GenerateComposite(int texnum)
     short *collump;
     unsigned short *colofs;
 
+    I_Trace(TRACE_COMPOSITE_BEGIN, texnum, texturecompositesize[texnum]);
+
     texture = textures[texnum];
 
     block = Z_Malloc(texturecompositesize[texnum], PU_STATIC, &texturecomposite[texnum]);
@@ -257,6 +260,8 @@ void R_GenerateComposite(int texnum)
     // Now that the texture has been built in column cache,
     //  it is purgable from zone memory.
     Z_ChangeTag(block, PU_CACHE);
+
+    I_Trace(TRACE_COMPOSITE_END, texnum, texturecompositesize[texnum]);
 }
 
 //
@@ -910,10 +915,13 @@ void R_PrecacheLevel(void)
 
     for (th = thinkercap.next; th != &thinkercap; th = th->next)
     {
-        if (th->function.acp1 == (actionf_p1)P_MobjThinker || th->function.acp1 == (actionf_p1)P_MobjBrainlessThinker || th->function.acp1 == (actionf_p1)P_MobjTicklessThinker)
+        if (th->function.acp1 == (actionf_p1)P_MobjThinker || th->function.acp1 == (actionf_p1)P_MobjBrainlessThinker)
             spritepresent[((mobj_t *)th)->sprite] = 1;
     }
 
+    for (th = ticklesscap.next; th != &ticklesscap; th = th->next)
+        spritepresent[((mobj_t *)th)->sprite] = 1;
+
     for (i = 0; i < NUMSPRITES; i++)
     {
         if (!spritepresent[i])
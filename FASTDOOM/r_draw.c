@@ -3746,3 +3746,78 @@ void R_DrawFuzzColumnTransPotatoBackbuffer(void)
 }
 
 #endif
+
+#if defined(USE_BACKBUFFER)
+
+//
+// Overdraw heatmap
+// Drawers count writes per pixel instead of storing texels.
+// The counts are mapped to a palette ramp once the view is done.
+//
+
+static const byte overdrawramp[] = {
+    0,   // never written (HOM), black
+    200, // 1 write, blue
+    112, // 2 writes, green
+    231, // 3 writes, yellow
+    176, // 4 writes, red
+    209, // 5+ writes, white
+};
+
+#define OVERDRAWRAMPMAX (sizeof(overdrawramp) - 1)
+
+static void R_OverdrawIncrement(byte *dest, int count)
+{
+    do
+    {
+        if (*dest < OVERDRAWRAMPMAX)
+            (*dest)++;
+        dest++;
+    } while (--count);
+}
+
+void R_DrawColumnOverdrawBackbuffer(void)
+{
+    int count;
+    int width;
+    byte *dest;
+
+    dest = ylookup[dc_yl] + columnofs[dc_x];
+    count = dc_yh - dc_yl;
+    width = 1 << detailshift;
+
+    do
+    {
+        R_OverdrawIncrement(dest, width);
+        dest += SCREENWIDTH;
+    } while (count--);
+}
+
+void R_DrawSpanOverdrawBackbuffer(void)
+{
+    R_OverdrawIncrement(ylookup[ds_y] + columnofs[ds_x1], (ds_x2 - ds_x1 + 1) << detailshift);
+}
+
+void R_ClearOverdrawBackbuffer(void)
+{
+    int y;
+
+    for (y = 0; y < viewheight; y++)
+        SetBytes(ylookup[y] + viewwindowx, 0, scaledviewwidth);
+}
+
+void R_FinishOverdrawBackbuffer(void)
+{
+    int x, y;
+    byte *dest;
+
+    for (y = 0; y < viewheight; y++)
+    {
+        dest = ylookup[y] + viewwindowx;
+
+        for (x = 0; x < scaledviewwidth; x++)
+            dest[x] = overdrawramp[dest[x]];
+    }
+}
+
+#endif
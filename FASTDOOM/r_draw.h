@@ -152,6 +152,10 @@ void R_DrawFuzzColumnFlatSaturnPotatoBackbuffer(void);
 void R_DrawFuzzColumnTransBackbuffer(void);
 void R_DrawFuzzColumnTransLowBackbuffer(void);
 void R_DrawFuzzColumnTransPotatoBackbuffer(void);
+void R_DrawColumnOverdrawBackbuffer(void);
+void R_DrawSpanOverdrawBackbuffer(void);
+void R_ClearOverdrawBackbuffer(void);
+void R_FinishOverdrawBackbuffer(void);
 
 void R_DrawColumnVBE2(void);
 void R_DrawColumnLowVBE2(void);
@@ -27,6 +27,7 @@
 #include "doomstat.h"
 #include "d_net.h"
 #include "i_debug.h"
+#include "i_log.h"
 #include "m_misc.h"
 
 #include "r_local.h"
@@ -103,6 +104,10 @@ void (*fuzzcolfunc)(void);
 void (*spanfunc)(void);
 void (*skyfunc)(void);
 
+#if (RENDERSTATS_ENABLED == 1)
+renderstats_t renderstats;
+#endif
+
 byte R_PointOnSegSide(fixed_t x,
                       fixed_t y,
                       seg_t *line)
@@ -1450,6 +1455,14 @@ void R_ExecuteSetViewSize(void)
 
         break;
     }
+
+    if (overdrawRender)
+    {
+        colfunc = basecolfunc = R_DrawColumnOverdrawBackbuffer;
+        fuzzcolfunc = R_DrawColumnOverdrawBackbuffer;
+        skyfunc = R_DrawColumnOverdrawBackbuffer;
+        spanfunc = R_DrawSpanOverdrawBackbuffer;
+    }
 #endif
 
 #if defined(MODE_VBE2_DIRECT)
@@ -1794,6 +1807,9 @@ void R_RenderPlayerView(void)
     R_ClearPlanes();
     R_ClearSprites();
 
+    if (pvsnodes)
+        R_UpdatePVS();
+
     // check for new console commands.
     NetUpdate();
 
@@ -1805,12 +1821,21 @@ void R_RenderPlayerView(void)
     }
 #endif
 
+#if defined(USE_BACKBUFFER)
+    if (overdrawRender)
+        R_ClearOverdrawBackbuffer();
+#endif
+
     // The head node is the last node output.
+    I_Trace(TRACE_STAGE_BEGIN, TRACE_STAGE_BSP, 0);
     R_RenderBSPNode(firstnode);
+    I_Trace(TRACE_STAGE_END, TRACE_STAGE_BSP, 0);
 
     // Check for new console commands.
     NetUpdate();
 
+    I_Trace(TRACE_STAGE_BEGIN, TRACE_STAGE_PLANES, 0);
+
 #if defined(MODE_T4050)
     if (visplaneRender == VISPLANES_FLATTER)
         R_DrawPlanesFlatterText4050();
@@ -1857,7 +1882,7 @@ void R_RenderPlayerView(void)
         R_DrawPlanes();
 #endif
 #if defined(USE_BACKBUFFER)
-    if (visplaneRender == VISPLANES_FLATTER)
+    if (visplaneRender == VISPLANES_FLATTER && !overdrawRender)
         switch (detailshift)
         {
         case DETAIL_HIGH:
@@ -1891,10 +1916,19 @@ void R_RenderPlayerView(void)
         R_DrawPlanes();
 #endif
 
+    I_Trace(TRACE_STAGE_END, TRACE_STAGE_PLANES, 0);
+
     // Check for new console commands.
     NetUpdate();
 
+    I_Trace(TRACE_STAGE_BEGIN, TRACE_STAGE_MASKED, 0);
     R_DrawMasked();
+    I_Trace(TRACE_STAGE_END, TRACE_STAGE_MASKED, 0);
+
+#if defined(USE_BACKBUFFER)
+    if (overdrawRender)
+        R_FinishOverdrawBackbuffer();
+#endif
 
     // Check for new console commands.
     NetUpdate();
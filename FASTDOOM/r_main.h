@@ -92,6 +92,58 @@ extern void (*fuzzcolfunc)(void);
 extern void (*spanfunc)(void);
 extern void (*skyfunc)(void);
 
+// Renderer workload counters, enabled with -dRENDERSTATS_ENABLED=1
+#if (RENDERSTATS_ENABLED == 1)
+typedef struct
+{
+    unsigned int segs;              // segs visited by R_AddLine
+    unsigned int drawsegs;          // wall ranges stored
+    unsigned int visplanes;         // visplanes allocated
+    unsigned int spans;             // spans drawn by R_MapPlane
+    unsigned int columns;           // wall and sky columns drawn
+    unsigned int pixels;            // screen pixels covered by columns, spans and flat fills
+    unsigned int vissprites;        // sprites projected
+    unsigned int maskedcolumns;     // sprite and masked mid texture posts
+} renderstats_t;
+
+extern renderstats_t renderstats;
+extern renderstats_t *framestats; // per frame copy, benchmark -advanced only
+
+#define RSTATS_ADD(field, value) (renderstats.field += (value))
+
+// Columns the mode draws and the screen pixels each one covers. Low and
+// potato detail columns cover 2 and 4, the CGA modes skip columns and
+// span rows and cover them with the ones they draw.
+#if defined(MODE_CGA16) || defined(MODE_CVB)
+#define RSTATS_DRAWN(x) (!((x) & (1 >> detailshift)))
+#define RSTATS_XSHIFT (detailshift == DETAIL_HIGH ? 1 : detailshift)
+#elif defined(MODE_CGA512)
+#define RSTATS_DRAWN(x) (!((x) & (3 >> detailshift)))
+#define RSTATS_XSHIFT 2
+#else
+#define RSTATS_DRAWN(x) 1
+#define RSTATS_XSHIFT detailshift
+#endif
+
+#if defined(MODE_CGA16) || defined(MODE_CGA512) || defined(MODE_CGA_AFH)
+#define RSTATS_YSHIFT 1
+#else
+#define RSTATS_YSHIFT 0
+#endif
+
+#define RSTATS_COLUMN(field) \
+    (RSTATS_DRAWN(dc_x) ? (renderstats.field++, renderstats.pixels += (dc_yh - dc_yl + 1) << RSTATS_XSHIFT) : 0)
+#define RSTATS_SPAN() (renderstats.spans++, renderstats.pixels += ((ds_x2 - ds_x1 + 1) << detailshift) << RSTATS_YSHIFT)
+#define RSTATS_PLANES() R_CountPlanePixels()
+
+void R_CountPlanePixels(void);
+#else
+#define RSTATS_ADD(field, value)
+#define RSTATS_COLUMN(field)
+#define RSTATS_SPAN()
+#define RSTATS_PLANES()
+#endif
+
 //
 // Utility functions.
 byte R_PointOnSegSide(fixed_t x,
@@ -168,6 +168,8 @@ void R_MapPlane(int y, int x1)
         ds_colormap = planezlight[index];
     }
 
+    RSTATS_SPAN();
+
     // high or low detail
     spanfunc();
 }
@@ -244,6 +246,8 @@ visplane_t *R_FindPlane(fixed_t height, int picnum, int lightlevel)
     if (check < lastvisplane)
         return check;
 
+    RSTATS_ADD(visplanes, 1);
+
     lastvisplane++;
 
     check->height = height;
@@ -305,6 +309,8 @@ visplane_t *R_CheckPlane(visplane_t *pl, int start, int stop)
     }
 
     // make a new visplane
+    RSTATS_ADD(visplanes, 1);
+
     lastvisplane->height = pl->height;
     lastvisplane->picnum = pl->picnum;
     lastvisplane->lightlevel = pl->lightlevel;
@@ -408,6 +414,31 @@ void R_DrawPlanes(void)
 // R_DrawPlanes
 // At the end of each frame.
 //
+#if (RENDERSTATS_ENABLED == 1)
+//
+// R_CountPlanePixels
+// The flatter renderers fill visplanes a column at a time, without
+// R_MapPlane
+//
+void R_CountPlanePixels(void)
+{
+    visplane_t *pl;
+    int x;
+
+    for (pl = visplanes; pl < lastvisplane; pl++)
+    {
+        if (!pl->modified || pl->minx > pl->maxx || pl->picnum == skyflatnum)
+            continue;
+
+        for (x = pl->minx; x <= pl->maxx; x++)
+        {
+            if (pl->top[x] <= pl->bottom[x] && RSTATS_DRAWN(x))
+                renderstats.pixels += (pl->bottom[x] - pl->top[x] + 1) << RSTATS_XSHIFT;
+        }
+    }
+}
+#endif
+
 void R_DrawPlanesFlatter(void)
 {
     visplane_t *pl;
@@ -417,6 +448,8 @@ void R_DrawPlanesFlatter(void)
     lighttable_t color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -601,6 +634,8 @@ void R_DrawPlanesFlatterLow(void)
     lighttable_t color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -705,6 +740,8 @@ void R_DrawPlanesFlatterPotato(void)
     lighttable_t color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -762,6 +799,8 @@ void R_DrawPlanesFlatterText8050(void)
     unsigned short color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -822,6 +861,8 @@ void R_DrawPlanesFlatterText4050(void)
     int x;
     byte odd;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -904,6 +945,8 @@ void R_DrawPlanesFlatterText4025(void)
     unsigned short color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -963,6 +1006,8 @@ void R_DrawPlanesFlatterTextMDA(void)
     int x;
     byte odd;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1043,6 +1088,8 @@ void R_DrawPlanesFlatterText8025(void)
     int x;
     byte odd;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1125,6 +1172,8 @@ void R_DrawPlanesFlatterBackbuffer(void)
     lighttable_t color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1179,6 +1228,8 @@ void R_DrawPlanesFlatterLowBackbuffer(void)
     unsigned short color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1229,6 +1280,8 @@ void R_DrawPlanesFlatterPotatoBackbuffer(void)
     unsigned int color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1278,6 +1331,8 @@ void R_DrawPlanesFlatterVBE2(void)
     lighttable_t color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1322,6 +1377,8 @@ void R_DrawPlanesFlatterLowVBE2(void)
     unsigned short color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1367,6 +1424,8 @@ void R_DrawPlanesFlatterPotatoVBE2(void)
     unsigned int color;
     int x;
 
+    RSTATS_PLANES();
+
     for (pl = visplanes; pl < lastvisplane; pl++)
     {
         if (!pl->modified || pl->minx > pl->maxx)
@@ -1463,6 +1522,8 @@ void R_DrawSky(visplane_t *pl)
 
             dc_x = x;
 
+            RSTATS_COLUMN(columns);
+
             angle = (viewangle + xtoviewangle[x]) >> ANGLETOSKYSHIFT;
 
             tex = skytexture;
@@ -1518,6 +1579,8 @@ void R_DrawSky(visplane_t *pl)
 
             dc_x = x;
 
+            RSTATS_COLUMN(columns);
+
             skyfunc();
         }
     }
@@ -245,6 +245,8 @@ void R_RenderMaskedSegRange(drawseg_t *ds,
 				dc_yh = yh;
 				dc_yl = yl;
 
+				RSTATS_COLUMN(maskedcolumns);
+
 #if defined(MODE_CGA16) || defined(MODE_CVB)
 				if (detailshift == DETAIL_HIGH)
 				{
@@ -441,6 +443,8 @@ void R_RenderMaskedSegRange2(drawseg_t *ds)
 				dc_yh = yh;
 				dc_yl = yl;
 
+				RSTATS_COLUMN(maskedcolumns);
+
 #if defined(MODE_CGA16) || defined(MODE_CVB)
 				if (detailshift == DETAIL_HIGH)
 				{
@@ -603,6 +607,8 @@ void R_RenderSegLoop(void)
 				dc_yh = yh;
 				dc_texturemid = rw_midtexturemid;
 
+				RSTATS_COLUMN(columns);
+
 				tex = midtexture;
 				col = texturecolumn;
 				col &= texturewidthmask[tex];
@@ -679,6 +685,8 @@ void R_RenderSegLoop(void)
 					dc_yh = mid;
 					dc_texturemid = rw_toptexturemid;
 
+					RSTATS_COLUMN(columns);
+
 					tex = toptexture;
 					col = texturecolumn;
 					col &= texturewidthmask[tex];
@@ -759,6 +767,8 @@ void R_RenderSegLoop(void)
 					dc_yh = yh;
 					dc_texturemid = rw_bottomtexturemid;
 
+					RSTATS_COLUMN(columns);
+
 					tex = bottomtexture;
 					col = texturecolumn;
 					col &= texturewidthmask[tex];
@@ -1149,5 +1159,7 @@ void R_StoreWallRange(int start,
 		}
 	}
 
+	RSTATS_ADD(drawsegs, 1);
+
 	ds_p++;
 }
@@ -74,11 +74,14 @@ extern seg_t *segs;
 extern int numsectors;
 extern sector_t *sectors;
 
+extern int numsubsectors;
 extern subsector_t *subsectors;
 
 extern int firstnode;
 extern node_t *nodes;
 
+extern byte *pvsmatrix;
+
 extern int numlines;
 extern line_t *lines;
 
@@ -346,6 +346,8 @@ void R_DrawVisSprite(vissprite_t *vis)
             dc_yh = yh;
             dc_yl = yl;
 
+            RSTATS_COLUMN(maskedcolumns);
+
 #if defined(MODE_CGA16) || defined(MODE_CVB)
             if (detailshift == DETAIL_HIGH)
             {
@@ -517,6 +519,8 @@ void R_ProjectSprite(mobj_t *thing)
     }
     vis = vissprites + num_vissprite++;
 
+    RSTATS_ADD(vissprites, 1);
+
 #if defined(MODE_T4050)
     vis->scale = xscale << 1;
 #endif
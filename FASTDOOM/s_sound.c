@@ -43,6 +43,8 @@
 #include "ns_multi.h"
 #include "ns_muldf.h"
 
+#include "i_log.h"
+
 // Current music/sfx card - index useless
 //  w/o a reference LUT in a sound module.
 extern int snd_MusicDevice;
@@ -57,7 +59,20 @@ int cdmusicnum = 0;
 int wavhandle = -1;
 int wavmusicnum = 0;
 int wavlooping = 0;
-unsigned char *wavfileptr = NULL;
+
+// Digital music is streamed from the file through a ring of chunks,
+// filled between frames and handed to the mixer one at a time. Chunks
+// hold whole ADPCM blocks.
+#define WAVCHUNKS 8
+#define WAVCHUNKSIZE 16384
+
+FILE *wavfile = NULL;
+byte wavadpcm;
+unsigned char *wavchunks = NULL;
+unsigned int wavchunklength[WAVCHUNKS];
+volatile unsigned int wavwrite; // Chunks filled, only the main loop changes it
+volatile unsigned int wavread;  // Chunks played, only the mixer changes it
+volatile byte wavfeeding;
 
 typedef struct
 {
@@ -70,11 +85,18 @@ typedef struct
     // handle of the sound being played
     int handle;
 
+    // importance when channels run out, see S_StartSound
+    int priority;
+
 } channel_t;
 
 // the set of channels available
 static channel_t *channels;
 
+// channels not in use
+static int *freechannels;
+static int numfreechannels;
+
 // These are not used, but should be (menu).
 // Maximum volume of a sound effect.
 // Internal default is max out of 0-15.
@@ -97,7 +119,7 @@ int snd_clipping = S_CLIPPING_DIST;
 //
 // Internals.
 //
-int S_getChannel(void *origin, sfxinfo_t *sfxinfo);
+int S_getChannel(void *origin, sfxinfo_t *sfxinfo, int priority);
 byte S_AdjustSoundParams(mobj_t *source, int *vol, int *sep);
 void S_StopChannel(int cnum);
 
@@ -150,7 +172,9 @@ void S_StopMusicMIDI(void)
             MUSIC_Continue();
 
         MUSIC_StopSong();
-        Z_Free(mus_playing->data);
+
+        // Keep the lump cached, changing back is free
+        Z_ChangeTag(mus_playing->data, PU_CACHE);
 
         mus_playing->data = 0;
         mus_playing = 0;
@@ -353,36 +377,70 @@ void S_CheckCD(void)
     }
 }
 
-unsigned char *LoadFile(char *filename, int *length)
+//
+// S_FeedWAV
+// Called by the mixer when it needs the next chunk. The previous one
+// has been played by then. Gives nothing if the ring runs dry.
+//
+void S_FeedWAV(char **ptr, unsigned long *length)
 {
-    FILE *in;
-    long size;
-    unsigned char *ptr;
+    unsigned int chunk;
 
-    if ((in = fopen(filename, "rb")) == NULL)
-        I_Error("File %s not found", filename);
+    if (wavfeeding)
+    {
+        wavread++;
+        wavfeeding = 0;
+    }
+
+    if (wavread == wavwrite)
+    {
+        *ptr = NULL;
+        *length = 0;
+        return;
+    }
+
+    chunk = wavread & (WAVCHUNKS - 1);
+
+    *ptr = (char *)wavchunks + chunk * WAVCHUNKSIZE;
+    *length = wavchunklength[chunk];
+    wavfeeding = 1;
+}
+
+//
+// S_ReadWAV
+// Reads the next chunk if the ring has room, looping music seeks back
+// to the start of the file. Returns 0 if nothing was read.
+//
+int S_ReadWAV(void)
+{
+    unsigned int chunk;
+    unsigned int length;
+    unsigned char *ptr;
 
-    fseek(in, 0, SEEK_END);
-    size = ftell(in);
-    fseek(in, 0, SEEK_SET);
+    if (wavwrite - wavread == WAVCHUNKS)
+        return 0;
 
-    ptr = (unsigned char *)malloc(size);
-    if (ptr == NULL)
-        I_Error("Out of memory, cannot load music file %s", filename);
+    chunk = wavwrite & (WAVCHUNKS - 1);
+    ptr = wavchunks + chunk * WAVCHUNKSIZE;
 
-    if (fread(ptr, size, 1, in) != 1)
-        I_Error("Error loading music file %s", filename);
+    length = fread(ptr, 1, WAVCHUNKSIZE, wavfile);
+    if (length < WAVCHUNKSIZE && wavlooping)
+    {
+        fseek(wavfile, 0, SEEK_SET);
+        length += fread(ptr + length, 1, WAVCHUNKSIZE - length, wavfile);
+    }
 
-    fclose(in);
+    if (length == 0)
+        return 0;
 
-    *length = size;
+    wavchunklength[chunk] = length;
+    wavwrite++;
 
-    return (ptr);
+    return 1;
 }
 
 void S_ChangeMusicWAV(int musicnum, int looping)
 {
-    int length;
     unsigned int sample_rate;
     int volume;
 
@@ -397,8 +455,15 @@ void S_ChangeMusicWAV(int musicnum, int looping)
     if (voicePlaying)
         MV_Kill(wavhandle);
 
-    if (wavfileptr != NULL)
-        free(wavfileptr);
+    if (wavfile != NULL)
+        fclose(wavfile);
+
+    if (wavchunks == NULL)
+    {
+        wavchunks = (unsigned char *)malloc(WAVCHUNKS * WAVCHUNKSIZE);
+        if (wavchunks == NULL)
+            I_Error("Out of memory, cannot stream music");
+    }
 
     memset(filename, 0, sizeof(filename));
     memset(subfolder, 0, sizeof(subfolder));
@@ -421,11 +486,32 @@ void S_ChangeMusicWAV(int musicnum, int looping)
         break;
     }
 
-    sprintf(filename, "MUSIC/%s/mus_%u.raw", subfolder, S_MapMusicCD(musicnum));
+    // IMA ADPCM files (SCRIPTS/PCMconvert) are preferred over raw PCM
+    sprintf(filename, "MUSIC/%s/mus_%u.adp", subfolder, S_MapMusicCD(musicnum));
+
+    if ((wavfile = fopen(filename, "rb")) != NULL)
+    {
+        wavadpcm = 1;
+    }
+    else
+    {
+        wavadpcm = 0;
+        sprintf(filename, "MUSIC/%s/mus_%u.raw", subfolder, S_MapMusicCD(musicnum));
+
+        if ((wavfile = fopen(filename, "rb")) == NULL)
+            I_Error("File %s not found", filename);
+    }
 
-    wavfileptr = LoadFile(filename, &length);
     wavmusicnum = musicnum;
 
+    // Start with a full ring
+    wavwrite = 0;
+    wavread = 0;
+    wavfeeding = 0;
+
+    while (S_ReadWAV())
+        ;
+
     switch(snd_PCMRate)
     {
         case 0:
@@ -441,16 +527,32 @@ void S_ChangeMusicWAV(int musicnum, int looping)
 
     volume = snd_MusicVolume;
 
-    wavhandle = MV_PlayRaw(wavfileptr, length, sample_rate, volume, volume, volume, 0);
+    if (wavadpcm)
+        wavhandle = MV_StartADPCMPlayback(S_FeedWAV, sample_rate, volume, volume, volume, MV_MaxPriority);
+    else
+        wavhandle = MV_StartDemandFeedPlayback(S_FeedWAV, sample_rate, volume, volume, volume, MV_MaxPriority);
 }
 
 void S_CheckWAV(void)
 {
-    if (wavlooping && !mus_paused)
+    if (mus_paused || wavfile == NULL)
+        return;
+
+    // Sound effects can take the voice, start over like before
+    if (!MV_VoicePlaying(wavhandle))
     {
-        if (!MV_VoicePlaying(wavhandle))
+        if (wavlooping)
             S_ChangeMusicWAV(wavmusicnum, wavlooping);
+        return;
     }
+
+    // One chunk per frame, more if the ring is running low
+    while (S_ReadWAV() && wavwrite - wavread < WAVCHUNKS / 2)
+        ;
+
+    // Music that doesn't loop ends when the ring runs dry
+    if (!wavlooping && wavread == wavwrite && feof(wavfile))
+        MV_Kill(wavhandle);
 }
 
 void S_ChangeMusicMIDI(int musicnum, int looping)
@@ -483,7 +585,7 @@ void S_ChangeMusicMIDI(int musicnum, int looping)
 
     // load & register it
     music->data = (void *)W_CacheLumpNum(music->lumpnum, PU_MUSIC);
-    music->handle = MUS_RegisterSong(music->data);
+    music->handle = MUS_RegisterSong(music->data, music->lumpnum);
 
     // play it
     MUS_ChainSong(music->handle, looping ? music->handle : -1);
@@ -520,8 +622,10 @@ void S_StopChannel(int cnum)
         if (SFX_Playing(c->handle))
         {
             SFX_StopPatch(c->handle);
+            I_Trace(TRACE_SOUND_STOP, cnum, 0);
         }
         c->sfxinfo = 0;
+        freechannels[numfreechannels++] = cnum;
     }
 }
 
@@ -666,50 +770,41 @@ void S_StopSound(void *origin)
 // S_getChannel :
 //   If none available, return -1.  Otherwise channel #.
 //
-int S_getChannel(void *origin, sfxinfo_t *sfxinfo)
+int S_getChannel(void *origin, sfxinfo_t *sfxinfo, int priority)
 {
     // channel number to use
     int cnum;
+    int i;
 
     channel_t *c;
 
-    // Find an open channel
-    for (cnum = 0; cnum < numChannels; cnum++)
+    // S_StartSound already stopped the sound of this origin
+    if (!numfreechannels)
     {
-        if (!channels[cnum].sfxinfo)
-            break;
-        else if (origin && channels[cnum].origin == origin)
-        {
-            S_StopChannel(cnum);
-            break;
-        }
-    }
+        // Look for the least important sound
+        cnum = 0;
+        for (i = 1; i < numChannels; i++)
+            if (channels[i].priority < channels[cnum].priority)
+                cnum = i;
 
-    // None available
-    if (cnum == numChannels)
-    {
-        // Look for lower priority
-        for (cnum = 0; cnum < numChannels; cnum++)
-            if (channels[cnum].sfxinfo->priority >= sfxinfo->priority)
-                break;
-
-        if (cnum == numChannels)
+        if (channels[cnum].priority > priority)
         {
             // FUCK!  No lower priority.  Sorry, Charlie.
             return -1;
         }
-        else
-        {
-            // Otherwise, kick out lower priority.
-            S_StopChannel(cnum);
-        }
+
+        // Otherwise, kick out lower priority.
+        S_StopChannel(cnum);
     }
 
+    cnum = freechannels[--numfreechannels];
+
     c = &channels[cnum];
 
     // channel is decided to be cnum.
     c->sfxinfo = sfxinfo;
     c->origin = origin;
+    c->priority = priority;
 
     return cnum;
 }
@@ -720,6 +815,7 @@ void S_StartSound(mobj_t *origin, byte sfx_id)
     sfxinfo_t *sfx;
     int cnum;
     int volume;
+    int priority;
 
     if (snd_SfxDevice == snd_none)
         return;
@@ -752,8 +848,12 @@ void S_StartSound(mobj_t *origin, byte sfx_id)
 
     sfx = &S_sfx[sfx_id];
 
+    // Sfx priority first (lower is more important), then how loud it is
+    // from here. Used to pick the channel and the mixer voice to steal.
+    priority = ((256 - sfx->priority) << 8) + volume;
+
     // try to find a channel
-    cnum = S_getChannel(origin, sfx);
+    cnum = S_getChannel(origin, sfx, priority);
 
     if (cnum < 0)
         return;
@@ -769,14 +869,21 @@ void S_StartSound(mobj_t *origin, byte sfx_id)
         sfx->lumpnum = I_GetSfxLumpNum(sfx);
 
     // cache data if necessary
+    if (sfx->resident)
+        sfx->resident = SFX_LockPatch(&sfx->data);
+
     if (!sfx->data)
     {
         sfx->data = (void *)W_CacheLumpNum(sfx->lumpnum, PU_SOUND);
+        sfx->resident = SFX_CachePatch(&sfx->data);
     }
 
     // Assigns the handle to one of the channels in the
     //  mix/output buffer.
-    channels[cnum].handle = SFX_PlayPatch(sfx->data, sep, volume);
+    channels[cnum].handle = SFX_PlayPatch(sfx->data, sep, volume, priority);
+
+    // Enough to replay the sound in SCRIPTS/MixBench
+    I_Trace(TRACE_SOUND_START, sfx_id, cnum | (volume << 8) | (sep << 16));
 }
 
 //
@@ -842,10 +949,15 @@ void S_Init(int sfxVolume, int musicVolume)
     // (the maximum numer of sounds rendered
     // simultaneously) within zone memory.
     channels = (channel_t *)Z_MallocUnowned(numChannels * sizeof(channel_t), PU_STATIC);
+    freechannels = (int *)Z_MallocUnowned(numChannels * sizeof(int), PU_STATIC);
 
     // Free all channels for use
     for (i = 0; i < numChannels; i++)
+    {
         channels[i].sfxinfo = 0;
+        freechannels[i] = numChannels - 1 - i;
+    }
+    numfreechannels = numChannels;
 
     // no sounds are playing, and they are not mus_paused
     mus_paused = 0;
@@ -855,6 +967,18 @@ void S_Init(int sfxVolume, int musicVolume)
         S_sfx[i].lumpnum = -1;
 }
 
+//
+// S_StopSounds
+//
+void S_StopSounds(void)
+{
+    int cnum;
+
+    for (cnum = 0; cnum < numChannels; cnum++)
+        if (channels[cnum].sfxinfo)
+            S_StopChannel(cnum);
+}
+
 //
 // Per level startup code.
 // Kills playing sounds at start of level,
@@ -862,14 +986,11 @@ void S_Init(int sfxVolume, int musicVolume)
 //
 void S_Start(void)
 {
-    int cnum;
     int mnum;
 
     // kill all playing sounds at start of level
     //  (trust me - a good idea)
-    for (cnum = 0; cnum < numChannels; cnum++)
-        if (channels[cnum].sfxinfo)
-            S_StopChannel(cnum);
+    S_StopSounds();
 
     // start new music for the level
     mus_paused = 0;
@@ -916,7 +1037,15 @@ void S_ClearSounds(void)
     // Clean up unused data.
     for (i = 1; i < NUMSFX; i++)
     {
-        if (S_sfx[i].data != 0)
+        if (S_sfx[i].data == 0)
+            continue;
+
+        if (S_sfx[i].resident)
+        {
+            // Kept until the memory is needed
+            SFX_ReleasePatch(S_sfx[i].data);
+        }
+        else
         {
             Z_Free(S_sfx[i].data);
             S_sfx[i].data = 0;
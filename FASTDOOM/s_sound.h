@@ -31,6 +31,9 @@
 
 #define NORM_SEP 128
 
+// Sound channels (snd_channels, -channels)
+#define MAX_CHANNELS 32
+
 #define S_STEREO_SWING (96 * 0x10000)
 
 // when to clip out sounds
@@ -63,6 +66,9 @@ void S_StartSound(mobj_t *origin, byte sound_id);
 // Stop sound for thing at <origin>
 void S_StopSound(void *origin);
 
+// Stop every playing sound effect
+void S_StopSounds(void);
+
 // Start music using <music_id> from sounds.h
 void S_StartMusic(int music_id);
 
@@ -41,6 +41,9 @@ struct sfxinfo_struct
 
     // lump number of sfx
     int lumpnum;
+
+    // data converted to the mix rate, purgable between levels
+    int resident;
 };
 
 //
@@ -30,6 +30,7 @@
 #include "z_zone.h"
 #include "options.h"
 #include "w_wad.h"
+#include "i_log.h"
 
 #define HASHTABLESIZE 4096
 
@@ -259,9 +260,13 @@ void W_ReadLump(int lump,
     else
         handle = l->handle;
 
+    I_Trace(TRACE_LUMP_READ_BEGIN, lump, l->size);
+
     lseek(handle, l->position, SEEK_SET);
     c = read(handle, dest, l->size);
 
+    I_Trace(TRACE_LUMP_READ_END, lump, l->size);
+
     if (l->handle == -1)
         close(handle);
 }
@@ -21,6 +21,7 @@
 #include "z_zone.h"
 #include "i_system.h"
 #include "doomdef.h"
+#include "i_log.h"
 
 //
 // ZONE MEMORY ALLOCATION
@@ -185,6 +186,7 @@ void *Z_Malloc(int size, byte tag, void *user)
 
                 // the rover can be the base block
                 base = base->prev;
+                I_Trace(TRACE_ZONE_PURGE, rover->size, rover->tag);
                 Z_Free((byte *)rover + sizeof(memblock_t));
                 base = base->next;
                 rover = base->next;
@@ -278,6 +280,7 @@ void *Z_MallocUnowned(int size, byte tag)
 
                 // the rover can be the base block
                 base = base->prev;
+                I_Trace(TRACE_ZONE_PURGE, rover->size, rover->tag);
                 Z_Free((byte *)rover + sizeof(memblock_t));
                 base = base->next;
                 rover = base->next;
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+nasm -f elf32 -DDJGPP_ASM -I../../FASTDOOM/ ../../FASTDOOM/ns_mix.asm -o ns_mix.o
+gcc -m32 -O2 -fno-pie -no-pie fastdoom_mixbench.c fastdoom_mixhost.c ns_mix.o -lm -o mixbench
+
+# mixrender links the real ns_multi.c, which has the kernel variables
+# without the leading _
+objcopy --redefine-sym _MV_HarshClipTable=MV_HarshClipTable \
+        --redefine-sym _MV_MixDestination=MV_MixDestination \
+        --redefine-sym _MV_MixPosition=MV_MixPosition \
+        --redefine-sym _MV_LeftVolume=MV_LeftVolume \
+        --redefine-sym _MV_RightVolume=MV_RightVolume \
+        --redefine-sym _MV_SampleSize=MV_SampleSize \
+        --redefine-sym _MV_RightChannelOffset=MV_RightChannelOffset \
+        ns_mix.o ns_mixr.o
+gcc -m32 -O2 -fno-pie -no-pie -Wno-unknown-pragmas -Wno-incompatible-pointer-types -Wno-int-conversion \
+    -Ihost -iquote ../../FASTDOOM fastdoom_mixrender.c fastdoom_mixhost.c ../../FASTDOOM/ns_multi.c \
+    ../../FASTDOOM/ns_usrho.c ../../FASTDOOM/sounds.c ns_mixr.o -lm -o mixrender
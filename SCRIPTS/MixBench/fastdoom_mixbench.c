@@ -0,0 +1,473 @@
+// Mixes N voices with the ns_mix.asm kernels on the host, once one voice
+// at a time into the 8 bit page (the default mixer) and once through the
+// 16 bit accumulation buffer (-accumMix), and writes both as WAV files.
+// The accumulation kernels are checked against a plain C version, and
+// the cycles per page of every mixer are reported.
+//
+// Build with build.sh (needs nasm and a 32 bit gcc)
+//
+// Usage: mixbench [voices] [seconds] [mono|stereo] [doom.wad]
+//
+// Without a WAD a few synthetic sounds are used. The per voice output
+// differs where the default mixer clipped between two voices, and in mono
+// because MV_Mix8BitMono skips two source samples on every page.
+//
+// The kernels patch themselves, on modern CPUs that costs more than the
+// mixing so the cycle counts only compare runs on the same machine.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "fastdoom_mixhost.h"
+
+#define MixBufferSize 256
+#define MaxVoices 64
+#define MaxSounds 128
+#define MixRate 22050
+
+// Shared with ns_mix.asm (built with DJGPP_ASM, so symbols have a leading _)
+char *MV_HarshClipTable __asm__("_MV_HarshClipTable");
+char *MV_MixDestination __asm__("_MV_MixDestination");
+unsigned long MV_MixPosition __asm__("_MV_MixPosition");
+short *MV_LeftVolume __asm__("_MV_LeftVolume");
+short *MV_RightVolume __asm__("_MV_RightVolume");
+int MV_SampleSize __asm__("_MV_SampleSize");
+int MV_RightChannelOffset __asm__("_MV_RightChannelOffset");
+
+void MV_Mix8BitMono(void) __asm__("_MV_Mix8BitMono");
+void MV_Mix8BitStereo(void) __asm__("_MV_Mix8BitStereo");
+void MV_Accum8BitMono(void) __asm__("_MV_Accum8BitMono");
+void MV_Accum8BitStereo(void) __asm__("_MV_Accum8BitStereo");
+void MV_DetectMMX(void) __asm__("_MV_DetectMMX");
+void MV_ClipAccumMMX(void) __asm__("_MV_ClipAccumMMX");
+
+static void CallClipMMX(short *src, char *dest, int count)
+{
+    __asm__ volatile("call *%3"
+                     : "+a"(src), "+d"(dest), "+b"(count)
+                     : "S"(MV_ClipAccumMMX)
+                     : "memory", "cc");
+}
+
+static int CallDetectMMX(void)
+{
+    int result;
+    __asm__ volatile("call *%1"
+                     : "=a"(result)
+                     : "S"(MV_DetectMMX)
+                     : "memory", "cc");
+    return result;
+}
+
+static unsigned long long Cycles(void)
+{
+    unsigned int lo, hi;
+    __asm__ volatile("rdtsc"
+                     : "=a"(lo), "=d"(hi));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+typedef struct
+{
+    unsigned char *data;
+    unsigned long length;
+    unsigned long rate;
+} sound_t;
+
+typedef struct
+{
+    int playing;
+    unsigned char *sound;
+    unsigned char *nextblock;
+    unsigned long blocklength;
+    unsigned long length;
+    unsigned long position;
+    unsigned long ratescale;
+    unsigned long fixedpointbuffersize;
+    short *left;
+    short *right;
+} voice_t;
+
+static sound_t sounds[MaxSounds];
+static int numsounds;
+
+static voice_t voices[MaxVoices];
+static int numvoices = 8;
+static int channels = 2;
+
+static short volumetable[64][256];
+static char harshclip[512 + 4];
+static char page[MixBufferSize * 2];
+static short accum[MixBufferSize * 2];
+
+// 0 per voice, 1 accumulate, 2 accumulate in C
+static int accumulate;
+static int mmx;
+
+static unsigned long long cycles;
+
+//
+// Sounds
+//
+
+// The DMX sound lumps of the WAD, or a few synthetic sounds
+static void LoadSounds(char *wadfile)
+{
+    unsigned char *synth[8];
+    unsigned char *data;
+    wadsound_t *lumps;
+    int numlumps, i;
+
+    if (wadfile)
+    {
+        lumps = LoadWAD(wadfile, &numlumps);
+    }
+    else
+    {
+        lumps = NULL;
+        numlumps = 0;
+    }
+
+    for (i = 0; i < numlumps && numsounds < MaxSounds; i++)
+    {
+        data = lumps[i].data;
+        sounds[numsounds].rate = data[2] | (data[3] << 8);
+        sounds[numsounds].length = (data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24)) - 32;
+        if (sounds[numsounds].length + 24 > (unsigned long)lumps[i].size)
+            sounds[numsounds].length = lumps[i].size - 24;
+        sounds[numsounds].data = data + 24;
+        numsounds++;
+    }
+
+    if (numsounds)
+        return;
+
+    numlumps = SynthSounds(synth);
+
+    for (i = 0; i < numlumps; i++)
+    {
+        data = synth[i];
+        sounds[numsounds].rate = data[2] | (data[3] << 8);
+        sounds[numsounds].length = (data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24)) - 32;
+        sounds[numsounds].data = data + 24;
+        numsounds++;
+    }
+}
+
+// What MV_Accum8BitMono / MV_Accum8BitStereo should do
+static void ReferenceKernel(unsigned long position, unsigned long rate,
+                            unsigned char *start, unsigned long length)
+{
+    short *dest = (short *)MV_MixDestination;
+
+    while (length--)
+    {
+        dest[0] += MV_LeftVolume[start[position >> 16]];
+        if (channels == 2)
+            dest[1] += MV_RightVolume[start[position >> 16]];
+        dest += channels;
+        position += rate;
+    }
+
+    MV_MixDestination = (char *)dest;
+    MV_MixPosition = position;
+}
+
+//
+// Mixer, same steps as MV_Mix / MV_GetNextRawBlock / MV_ServiceVoc
+//
+
+static int GetNextBlock(voice_t *voice)
+{
+    if (voice->blocklength == 0)
+    {
+        voice->playing = 0;
+        return 0;
+    }
+
+    voice->sound = voice->nextblock;
+    voice->position -= voice->length;
+    voice->length = voice->blocklength < 0x8000 ? voice->blocklength : 0x8000;
+    voice->nextblock += voice->length;
+    voice->blocklength -= voice->length;
+    voice->length <<= 16;
+
+    return 1;
+}
+
+static void MixVoice(voice_t *voice)
+{
+    kernel_t kernel;
+    unsigned long FixedPointBufferSize;
+    unsigned long position, rate;
+    long voclength;
+    int length;
+
+    if (voice->length == 0 && !GetNextBlock(voice))
+        return;
+
+    length = MixBufferSize;
+    FixedPointBufferSize = voice->fixedpointbuffersize;
+
+    MV_LeftVolume = voice->left;
+    MV_RightVolume = voice->right;
+
+    if (accumulate)
+    {
+        MV_MixDestination = (char *)accum;
+        kernel = channels == 1 ? MV_Accum8BitMono : MV_Accum8BitStereo;
+    }
+    else
+    {
+        MV_MixDestination = page;
+        kernel = channels == 1 ? MV_Mix8BitMono : MV_Mix8BitStereo;
+
+        if (channels == 2 && MV_LeftVolume == volumetable[0])
+        {
+            MV_LeftVolume = MV_RightVolume;
+            MV_MixDestination += MV_RightChannelOffset;
+        }
+    }
+
+    while (length > 0)
+    {
+        rate = voice->ratescale;
+        position = voice->position;
+
+        if (position + FixedPointBufferSize >= voice->length)
+        {
+            if (position < voice->length)
+            {
+                voclength = (voice->length - position + rate - 1) / rate;
+            }
+            else
+            {
+                GetNextBlock(voice);
+                return;
+            }
+        }
+        else
+        {
+            voclength = length;
+        }
+
+        if (accumulate == 2)
+            ReferenceKernel(position, rate, voice->sound, voclength);
+        else
+            CallKernel(kernel, position, rate, voice->sound, voclength);
+
+        if (!accumulate && (voclength & 1))
+        {
+            MV_MixPosition += rate;
+            voclength -= 1;
+        }
+        voice->position = MV_MixPosition;
+
+        length -= voclength;
+
+        if (voice->position >= voice->length)
+        {
+            if (!GetNextBlock(voice))
+                return;
+
+            if (length > 0)
+                FixedPointBufferSize = voice->ratescale * (length - 1);
+        }
+    }
+}
+
+static void ClipAccum(void)
+{
+    int i, sample;
+
+    if (mmx && accumulate == 1)
+    {
+        CallClipMMX(accum, page, MixBufferSize * channels);
+        return;
+    }
+
+    for (i = 0; i < MixBufferSize * channels; i++)
+    {
+        sample = accum[i] + 0x80;
+        page[i] = sample < 0 ? 0 : sample > 255 ? 255 : sample;
+        accum[i] = 0;
+    }
+}
+
+static void MixPage(void)
+{
+    unsigned long long start;
+    int i;
+
+    start = Cycles();
+
+    if (!accumulate)
+        memset(page, 0x80, MixBufferSize * channels);
+
+    for (i = 0; i < numvoices; i++)
+    {
+        if (voices[i].playing)
+            MixVoice(&voices[i]);
+    }
+
+    if (accumulate)
+        ClipAccum();
+
+    cycles += Cycles() - start;
+}
+
+// Voices are restarted on fixed pages, so both mixers get the same
+// sound starts no matter where their voices end
+static void StartVoices(int pagenum)
+{
+    int i;
+
+    for (i = 0; i < numvoices; i++)
+    {
+        voice_t *voice = &voices[i];
+        sound_t *sound;
+        unsigned int seed;
+        int vol, sep;
+
+        if ((pagenum + i * 7) % 40)
+            continue;
+
+        seed = pagenum * 7919 + i * 104729;
+        sound = &sounds[seed % numsounds];
+        vol = 32 + (seed >> 5) % 32;
+        sep = (seed >> 10) % 255;
+
+        voice->playing = 1;
+        voice->nextblock = sound->data;
+        voice->blocklength = sound->length;
+        voice->length = 0;
+        voice->position = 0;
+        voice->ratescale = (sound->rate << 16) / MixRate;
+        voice->fixedpointbuffersize = voice->ratescale * MixBufferSize - voice->ratescale;
+        if (channels == 1)
+        {
+            voice->left = voice->right = volumetable[vol];
+        }
+        else
+        {
+            voice->left = volumetable[(254 - sep) * vol / 254];
+            voice->right = volumetable[sep * vol / 254];
+        }
+    }
+}
+
+static unsigned char *Render(int pages)
+{
+    unsigned char *output = malloc(pages * MixBufferSize * channels);
+    int i;
+
+    memset(voices, 0, sizeof(voices));
+    memset(accum, 0, sizeof(accum));
+    cycles = 0;
+
+    for (i = 0; i < pages; i++)
+    {
+        StartVoices(i);
+        MixPage();
+        memcpy(output + i * MixBufferSize * channels, page, MixBufferSize * channels);
+    }
+
+    return output;
+}
+
+static int Compare(unsigned char *a, unsigned char *b, int length)
+{
+    int i, diff = 0;
+
+    for (i = 0; i < length; i++)
+        diff += a[i] != b[i];
+
+    return diff;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned char *perpage, *reference, *accumC, *accumMMX;
+    unsigned long long cyclesPage, cyclesReference, cyclesC, cyclesMMX;
+    long pagesize;
+    int seconds = 10;
+    int pages, length, i, j;
+
+    if (argc > 1)
+        numvoices = atoi(argv[1]);
+    if (argc > 2)
+        seconds = atoi(argv[2]);
+    if (argc > 3 && !strcmp(argv[3], "mono"))
+        channels = 1;
+    LoadSounds(argc > 4 ? argv[4] : NULL);
+
+    if (numvoices < 1 || numvoices > MaxVoices)
+        numvoices = 8;
+
+    // The kernels patch themselves
+    pagesize = sysconf(_SC_PAGESIZE);
+    mprotect((void *)((unsigned long)MV_Mix8BitMono & ~(pagesize - 1)), pagesize * 4,
+             PROT_READ | PROT_WRITE | PROT_EXEC);
+
+    // Same tables as MV_CalcVolume / MV_CreateVolumeTable
+    for (i = 0; i < 128; i++)
+    {
+        harshclip[i] = 0;
+        harshclip[i + 384] = 255;
+    }
+    for (i = 0; i < 256; i++)
+        harshclip[i + 128] = i;
+    MV_HarshClipTable = harshclip + 128;
+
+    for (i = 0; i < 64; i++)
+        for (j = 0; j < 256; j++)
+            volumetable[i][j] = (j - 0x80) * i / 63;
+
+    MV_SampleSize = channels;
+    MV_RightChannelOffset = channels / 2;
+
+    pages = seconds * MixRate / MixBufferSize;
+    length = pages * MixBufferSize * channels;
+
+    accumulate = 0;
+    perpage = Render(pages);
+    cyclesPage = cycles;
+
+    accumulate = 2;
+    reference = Render(pages);
+    cyclesReference = cycles;
+
+    accumulate = 1;
+    accumC = Render(pages);
+    cyclesC = cycles;
+
+    mmx = CallDetectMMX();
+    accumMMX = NULL;
+    cyclesMMX = 0;
+    if (mmx)
+    {
+        accumMMX = Render(pages);
+        cyclesMMX = cycles;
+    }
+
+    WriteWAV("perpage.wav", perpage, length, MixRate, channels);
+    WriteWAV("accum.wav", accumC, length, MixRate, channels);
+
+    printf("%d voices, %d sounds, %s, %d pages of %d samples at %d Hz\n",
+           numvoices, numsounds, channels == 1 ? "mono" : "stereo", pages, MixBufferSize, MixRate);
+    printf("per voice:         %8llu cycles/page\n", cyclesPage / pages);
+    printf("accumulate (C):    %8llu cycles/page, %d of %d samples differ from per voice\n",
+           cyclesReference / pages, Compare(perpage, reference, length), length);
+    printf("accumulate:        %8llu cycles/page, %d samples differ from C\n",
+           cyclesC / pages, Compare(reference, accumC, length));
+    if (mmx)
+    {
+        printf("accumulate (MMX):  %8llu cycles/page, %d samples differ from C\n",
+               cyclesMMX / pages, Compare(reference, accumMMX, length));
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Host side helpers shared by mixbench and mixrender, see
+// fastdoom_mixhost.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "fastdoom_mixhost.h"
+
+//
+// Kernels, ns_mix.asm takes its arguments in eax, edx, ebx and ecx
+//
+
+void CallKernel(kernel_t kernel, unsigned long position, unsigned long rate,
+                unsigned char *start, unsigned long length)
+{
+    __asm__ volatile("call *%4"
+                     : "+a"(position), "+d"(rate), "+b"(start), "+c"(length)
+                     : "S"(kernel)
+                     : "memory", "cc");
+}
+
+//
+// Sounds, in the DMX format SFX_PlayPatch takes
+//
+
+unsigned char *MakeSound(unsigned char *samples, unsigned long length, int rate)
+{
+    unsigned char *data = malloc(length + 40);
+
+    data[0] = 3;
+    data[1] = 0;
+    data[2] = rate & 0xff;
+    data[3] = rate >> 8;
+    data[4] = (length + 32) & 0xff;
+    data[5] = ((length + 32) >> 8) & 0xff;
+    data[6] = ((length + 32) >> 16) & 0xff;
+    data[7] = (length + 32) >> 24;
+    memset(data + 8, 0x80, 16);
+    memcpy(data + 24, samples, length);
+    memset(data + 24 + length, 0x80, 16);
+
+    return data;
+}
+
+// The DMX sound lumps of a WAD, in directory order
+wadsound_t *LoadWAD(char *filename, int *numsounds)
+{
+    FILE *f;
+    char id[4];
+    int numlumps, infotable, i;
+    wadsound_t *sounds;
+
+    f = fopen(filename, "rb");
+    if (!f)
+    {
+        printf("Can't open %s\n", filename);
+        exit(1);
+    }
+
+    fread(id, 1, 4, f);
+    fread(&numlumps, 4, 1, f);
+    fread(&infotable, 4, 1, f);
+
+    sounds = malloc(numlumps * sizeof(wadsound_t));
+    *numsounds = 0;
+
+    for (i = 0; i < numlumps; i++)
+    {
+        wadsound_t *sound = &sounds[*numsounds];
+        int filepos, size;
+        unsigned char *lump;
+
+        fseek(f, infotable + i * 16, SEEK_SET);
+        fread(&filepos, 4, 1, f);
+        fread(&size, 4, 1, f);
+        fread(sound->name, 1, 8, f);
+        sound->name[8] = 0;
+
+        if (strncmp(sound->name, "DS", 2) || size <= 56)
+            continue;
+
+        lump = malloc(size);
+        fseek(f, filepos, SEEK_SET);
+        fread(lump, 1, size, f);
+
+        if (lump[0] != 3 || lump[1] != 0)
+        {
+            free(lump);
+            continue;
+        }
+
+        sound->data = lump;
+        sound->size = size;
+        (*numsounds)++;
+    }
+
+    fclose(f);
+
+    return sounds;
+}
+
+// Eight sounds at 11025 Hz, noise and tones that fade out
+int SynthSounds(unsigned char **sounds)
+{
+    unsigned char samples[20000];
+    int i, j;
+
+    for (i = 1; i <= 8; i++)
+    {
+        int length = 2000 + i * 1500;
+
+        for (j = 0; j < length; j++)
+        {
+            double env = 1.0 - (double)j / length;
+            double s;
+
+            if (i & 1)
+                s = ((rand() & 255) - 128) / 128.0;
+            else
+                s = sin(j * (0.05 + i * 0.04));
+
+            samples[j] = 128 + (int)(s * env * 127);
+        }
+
+        sounds[i - 1] = MakeSound(samples, length, 11025);
+    }
+
+    return 8;
+}
+
+//
+// Output
+//
+
+void WriteWAV(char *filename, unsigned char *data, int length, int rate, int channels)
+{
+    FILE *f = fopen(filename, "wb");
+    int value;
+
+    fwrite("RIFF", 1, 4, f);
+    value = 36 + length;
+    fwrite(&value, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    value = 16;
+    fwrite(&value, 4, 1, f);
+    value = 1 | (channels << 16);
+    fwrite(&value, 4, 1, f);
+    value = rate;
+    fwrite(&value, 4, 1, f);
+    value = rate * channels;
+    fwrite(&value, 4, 1, f);
+    value = channels | (8 << 16);
+    fwrite(&value, 4, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&length, 4, 1, f);
+    fwrite(data, 1, length, f);
+    fclose(f);
+}
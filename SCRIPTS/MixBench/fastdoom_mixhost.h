@@ -0,0 +1,27 @@
+// Host side helpers shared by mixbench and mixrender: calling the
+// ns_mix.asm kernels, loading and synthesizing sounds in the DMX format
+// and writing WAV files.
+
+#ifndef __FASTDOOM_MIXHOST__
+#define __FASTDOOM_MIXHOST__
+
+typedef void (*kernel_t)(void);
+
+// A DS* lump, data is the whole DMX patch
+typedef struct
+{
+    char name[9];
+    unsigned char *data;
+    int size;
+} wadsound_t;
+
+void CallKernel(kernel_t kernel, unsigned long position, unsigned long rate,
+                unsigned char *start, unsigned long length);
+
+unsigned char *MakeSound(unsigned char *samples, unsigned long length, int rate);
+wadsound_t *LoadWAD(char *filename, int *numlumps);
+int SynthSounds(unsigned char **sounds);
+
+void WriteWAV(char *filename, unsigned char *data, int length, int rate, int channels);
+
+#endif
@@ -0,0 +1,653 @@
+// Runs the real multivoc mixer (ns_multi.c and the ns_mix.asm kernels)
+// on the host with the sound card, DMA and interrupt layers stubbed out.
+// A sequence of sound starts is played through MV_PlayRaw and the pages
+// MV_ServiceVoc mixes are written to a WAV file, once per voice count.
+//
+// The sequence comes from a TRACE.BIN of a TRACE_ENABLED=1 build (play
+// a demo, the sound starts and stops are in the trace) or, without one,
+// from a fixed pseudo random script. Sounds are played the way
+// SFX_PlayPatch does, converted to the mix rate first like
+// SFX_CachePatch unless -nocache is given. Volume and separation
+// changes of moving sounds aren't in the trace and aren't replayed.
+//
+// Build with build.sh (needs nasm and a 32 bit gcc)
+//
+// Usage: mixrender [options] [doom.wad]
+//   -trace TRACE.BIN  script from a trace, needs the WAD of the demo
+//   -voices 4,8,16,32 voice counts to render
+//   -rate 22050       mix rate
+//   -seconds 60       length of the synthetic script
+//   -mono             mono instead of stereo
+//   -accum            use the accumulating mixer (-accumMix)
+//   -nocache          play the sounds at their own rate
+//
+// Every run writes render<voices>.wav. Keep them around and compare
+// them after changing the mixer, the speed goes to stdout.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ns_dpmi.h"
+#include "ns_inter.h"
+#include "ns_dma.h"
+#include "ns_cards.h"
+#include "ns_sb.h"
+#include "ns_scape.h"
+#include "ns_dsney.h"
+#include "ns_pas16.h"
+#include "ns_gusau.h"
+#include "ns_multi.h"
+#include "ns_muldf.h"
+#include "ns_speak.h"
+#include "ns_pwm.h"
+#include "ns_cms.h"
+#include "ns_lpt.h"
+#include "ns_sbdm.h"
+#include "ns_adbfx.h"
+#include "ns_tandy.h"
+#include "ns_fxm.h"
+#include "fastmath.h"
+#include "doomtype.h"
+#include "sounds.h"
+
+#include "fastdoom_mixhost.h"
+
+// Not in the headers
+extern char *MV_MixBuffer[];
+
+#define MaxScript 65536
+#define MaxChannels 256
+
+// i_log.h
+#define TRACE_SOUND_START 9
+#define TRACE_SOUND_STOP 10
+
+//
+// Kernels, called through CallKernel (ns_mix.asm is built with
+// DJGPP_ASM, so its symbols have a leading _)
+//
+
+#define KERNEL(name)                                                                     \
+    void name##_asm(void) __asm__("_" #name);                                           \
+    void name(unsigned long position, unsigned long rate, unsigned char *start,          \
+              unsigned long length)                                                      \
+    {                                                                                    \
+        CallKernel(name##_asm, position, rate, start, length);                           \
+    }
+
+KERNEL(MV_Mix8BitMono)
+KERNEL(MV_Mix8BitStereo)
+KERNEL(MV_Mix8BitUltrasound)
+KERNEL(MV_Mix8BitMono1)
+KERNEL(MV_Mix8BitStereo1)
+KERNEL(MV_Mix8BitUltrasound1)
+KERNEL(MV_Accum8BitMono)
+KERNEL(MV_Accum8BitStereo)
+
+void MV_DetectMMX_asm(void) __asm__("_MV_DetectMMX");
+void MV_ClipAccumMMX_asm(void) __asm__("_MV_ClipAccumMMX");
+
+int MV_DetectMMX(void)
+{
+    int result;
+    __asm__ volatile("call *%1"
+                     : "=a"(result)
+                     : "S"(MV_DetectMMX_asm)
+                     : "memory", "cc");
+    return result;
+}
+
+void MV_ClipAccumMMX(short *src, char *dest, int count)
+{
+    __asm__ volatile("call *%3"
+                     : "+a"(src), "+d"(dest), "+b"(count)
+                     : "S"(MV_ClipAccumMMX_asm)
+                     : "memory", "cc");
+}
+
+//
+// Watcom inline helpers
+//
+
+void ClearBuffer_DW(void *ptr, unsigned data, int length)
+{
+    unsigned *dest = (unsigned *)ptr;
+
+    while (length--)
+        *dest++ = data;
+}
+
+void SetDWords(void *dest, int value, int num_dwords)
+{
+    ClearBuffer_DW(dest, value, num_dwords);
+}
+
+void SetBytes(void *dest, unsigned char value, int num_bytes)
+{
+    memset(dest, value, num_bytes);
+}
+
+int Div63(int value)
+{
+    return value / 63;
+}
+
+unsigned long DisableInterrupts(void)
+{
+    return 0;
+}
+
+void RestoreInterrupts(unsigned long flags)
+{
+}
+
+//
+// DOS memory, 64 KB aligned so MV_Init never moves the mix buffer
+//
+
+static char dosmemory[2 * TotalBufferSize] __attribute__((aligned(0x10000)));
+
+int DPMI_GetDOSMemory(void **ptr, int *descriptor, unsigned length)
+{
+    if (length > sizeof(dosmemory))
+        return DPMI_Error;
+
+    *ptr = dosmemory;
+    *descriptor = 0;
+    return DPMI_Ok;
+}
+
+int DPMI_FreeDOSMemory(int descriptor)
+{
+    return DPMI_Ok;
+}
+
+char *DMA_GetCurrentPos(int channel)
+{
+    return NULL;
+}
+
+//
+// Sound cards. The Sound Blaster "plays" whatever the mix mode asks
+// for, without DMA, so MV_ServiceVoc just mixes the next page each call.
+//
+
+BLASTER_CONFIG BLASTER_Config = {0x220, SB16, 5, 1, 5, 0x330, 0};
+int BLASTER_DMAChannel = -1;
+unsigned BLASTER_SampleRate;
+
+int BLASTER_Init(void) { return BLASTER_Ok; }
+void BLASTER_Shutdown(void) {}
+void BLASTER_StopPlayback(void) {}
+int BLASTER_SetMixMode(int mode) { return mode & STEREO; }
+
+int BLASTER_BeginBufferedPlayback(char *BufferStart, int BufferSize, int NumDivisions,
+                                  unsigned SampleRate, int MixMode, void (*CallBackFunc)(void))
+{
+    BLASTER_SampleRate = SampleRate;
+    return BLASTER_Ok;
+}
+
+// Not used, only here to link
+unsigned int FX_MixRate;
+int dmx_snd_port;
+unsigned int PAS_DMAChannel;
+int SOUNDSCAPE_DMAChannel;
+
+int GUSWAVE_Init(void) { return -1; }
+void GUSWAVE_Shutdown(void) {}
+int GUSWAVE_KillAllVoices(void) { return 0; }
+int GUSWAVE_StartDemandFeedPlayback(void (*function)(char **ptr, unsigned long *length),
+                                    int bits, int rate, int angle) { return -1; }
+int PAS_Init(void) { return -1; }
+void PAS_Shutdown(void) {}
+void PAS_StopPlayback(void) {}
+int PAS_SetMixMode(int mode) { return mode; }
+unsigned PAS_GetPlaybackRate(void) { return 0; }
+int PAS_BeginBufferedPlayback(char *BufferStart, int BufferSize, int NumDivisions,
+                              unsigned SampleRate, int MixMode, void (*CallBackFunc)(void)) { return -1; }
+int SOUNDSCAPE_Init(void) { return -1; }
+void SOUNDSCAPE_Shutdown(void) {}
+void SOUNDSCAPE_StopPlayback(void) {}
+int SOUNDSCAPE_SetMixMode(int mode) { return mode; }
+unsigned SOUNDSCAPE_GetPlaybackRate(void) { return 0; }
+int SOUNDSCAPE_BeginBufferedPlayback(char *BufferStart, int BufferSize, int NumDivisions,
+                                     unsigned SampleRate, int MixMode, void (*CallBackFunc)(void)) { return -1; }
+
+#define BUFFEREDCARD(prefix)                                                              \
+    void prefix##_Shutdown(void) {}                                                       \
+    void prefix##_StopPlayback(void) {}                                                   \
+    int prefix##_BeginBufferedPlayback(char *BufferStart, int BufferSize, int NumDivisions, \
+                                       void (*CallBackFunc)(void)) { return -1; }
+
+BUFFEREDCARD(SS)
+BUFFEREDCARD(PCSpeaker)
+BUFFEREDCARD(PCSpeaker_PWM)
+BUFFEREDCARD(CMS)
+BUFFEREDCARD(LPT)
+BUFFEREDCARD(SBDM)
+BUFFEREDCARD(ADBFX)
+BUFFEREDCARD(TANDY)
+
+int SS_Init(int soundcard, int port) { return -1; }
+int PCSpeaker_Init(int soundcard) { return -1; }
+int PCSpeaker_PWM_Init(int soundcard) { return -1; }
+int CMS_Init(int soundcard, int port) { return -1; }
+int LPT_Init(int soundcard, int port) { return -1; }
+int SBDM_Init(int soundcard) { return -1; }
+int ADBFX_Init(int soundcard, int address) { return -1; }
+int TANDY_Init(int soundcard) { return -1; }
+
+//
+// Sounds, in the DMX format SFX_PlayPatch takes
+//
+
+static unsigned char *sounds[NUMSFX];
+static int numsounds;
+static int mixrate = 22050;
+static int cache = 1;
+
+// Same conversion as SFX_CachePatch
+static unsigned char *CacheSound(unsigned char *data)
+{
+    unsigned char *samples, *dest;
+    unsigned long rate, len, newlen, step, frac, i;
+
+    rate = (data[3] << 8) | data[2];
+    len = (data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4];
+    if (len <= 48 || rate == mixrate)
+        return data;
+    len -= 32;
+
+    step = (rate << 16) / mixrate;
+    if (!step)
+        return data;
+
+    newlen = 0;
+    for (i = 0, frac = 0; i < len; newlen++)
+    {
+        frac += step;
+        i += frac >> 16;
+        frac &= 0xffff;
+    }
+
+    samples = malloc(newlen);
+    dest = samples;
+    for (i = 0, frac = 0; dest < samples + newlen;)
+    {
+        *dest++ = data[24 + i];
+        frac += step;
+        i += frac >> 16;
+        frac &= 0xffff;
+    }
+
+    dest = MakeSound(samples, newlen, mixrate);
+    free(samples);
+    free(data);
+
+    return dest;
+}
+
+//
+// Script
+//
+
+typedef struct
+{
+    int page;
+    int type;
+    int sfx;
+    int channel;
+    int volume;
+    int sep;
+} scriptevent_t;
+
+static scriptevent_t script[MaxScript];
+static int numscript;
+static int numpages;
+
+static void LoadTrace(char *filename)
+{
+    FILE *f;
+    unsigned int header[4];
+    unsigned int event[4];
+    unsigned long long time, first = 0;
+    unsigned int last = 0, wraps = 0;
+    unsigned int i;
+    int started = 0;
+
+    f = fopen(filename, "rb");
+    if (!f)
+    {
+        printf("Can't open %s\n", filename);
+        exit(1);
+    }
+
+    fread(header, sizeof(header), 1, f);
+    if (header[0] != ('F' | ('D' << 8) | ('T' << 16) | ('R' << 24)) || header[1] < 2)
+    {
+        printf("%s isn't a version 2 trace\n", filename);
+        exit(1);
+    }
+
+    for (i = 0; i < header[3] && numscript < MaxScript; i++)
+    {
+        scriptevent_t *ev = &script[numscript];
+
+        if (fread(event, sizeof(event), 1, f) != 1)
+            break;
+
+        // The clock wraps after about an hour, only a drop of more than
+        // half the range is a wrap, as in fastdoom_trace2json.py
+        if (event[0] < last && last - event[0] > 0x80000000u)
+            wraps++;
+        last = event[0];
+        time = event[0] + ((unsigned long long)wraps << 32);
+
+        if (event[1] != TRACE_SOUND_START && event[1] != TRACE_SOUND_STOP)
+            continue;
+
+        if (!started)
+        {
+            first = time;
+            started = 1;
+        }
+
+        ev->page = (time - first) * mixrate / header[2] / MixBufferSize;
+        ev->type = event[1];
+
+        if (ev->type == TRACE_SOUND_START)
+        {
+            ev->sfx = event[2];
+            ev->channel = event[3] & 0xff;
+            ev->volume = (event[3] >> 8) & 0xff;
+            ev->sep = (event[3] >> 16) & 0xff;
+
+            if (ev->sfx <= 0 || ev->sfx >= NUMSFX || !sounds[ev->sfx])
+                continue;
+        }
+        else
+        {
+            ev->channel = event[2] & 0xff;
+        }
+
+        numscript++;
+    }
+
+    fclose(f);
+
+    // Let the last sounds finish
+    if (numscript)
+        numpages = script[numscript - 1].page + 3 * mixrate / MixBufferSize;
+}
+
+// A start every 40 ms on average, a few sounds at once most of the time
+static void SynthScript(int seconds)
+{
+    unsigned int seed = 1;
+    int page, sfx, channel = 0;
+
+    numpages = seconds * mixrate / MixBufferSize;
+
+    for (page = 0; page < numpages && numscript < MaxScript; page++)
+    {
+        seed = seed * 1103515245 + 12345;
+
+        if ((seed >> 16) % 1000 >= 1000 * MixBufferSize / (mixrate / 25))
+            continue;
+
+        seed = seed * 1103515245 + 12345;
+
+        do
+        {
+            sfx = 1 + (seed >> 8) % (NUMSFX - 1);
+            seed = seed * 1103515245 + 12345;
+        } while (!sounds[sfx]);
+
+        script[numscript].page = page;
+        script[numscript].type = TRACE_SOUND_START;
+        script[numscript].sfx = sfx;
+        script[numscript].channel = channel;
+        script[numscript].volume = 16 + (seed >> 12) % 105;
+        script[numscript].sep = 1 + (seed >> 20) % 254;
+        numscript++;
+
+        channel = (channel + 1) & 31;
+    }
+}
+
+//
+// Render
+//
+
+static int handles[MaxChannels];
+static int starts, dropped;
+
+static void PlayEvent(scriptevent_t *ev)
+{
+    unsigned char *data;
+    unsigned long len;
+    int rate, vol, sep, priority;
+
+    // The channel is reused, S_StopChannel stopped the old sound
+    if (handles[ev->channel] > 0)
+    {
+        MV_Kill(handles[ev->channel]);
+        handles[ev->channel] = 0;
+    }
+
+    if (ev->type != TRACE_SOUND_START)
+        return;
+
+    // As in S_StartSound and SFX_PlayPatch
+    data = sounds[ev->sfx];
+    vol = ev->volume;
+    sep = ev->sep;
+    priority = ((256 - S_sfx[ev->sfx].priority) << 8) + vol;
+
+    rate = (data[3] << 8) | data[2];
+    len = ((data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4]) - 32;
+
+    starts++;
+    handles[ev->channel] = MV_PlayRaw(data + 24, len, rate, vol * 2, Div63((254 - sep) * vol),
+                                      Div63(sep * vol), priority);
+    if (handles[ev->channel] < 0)
+    {
+        handles[ev->channel] = 0;
+        dropped++;
+    }
+}
+
+static double Seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void Render(int voices, int channels, int accumulate)
+{
+    unsigned char *output;
+    double time, start;
+    long long voicepages;
+    int pagesize, numbuffers;
+    int page, mixpage, next, i, active;
+    char filename[32];
+
+    if (MV_Init(SoundBlaster, mixrate, voices, channels, 8) != MV_Ok)
+    {
+        printf("MV_Init failed\n");
+        exit(1);
+    }
+
+    MV_SetAccumulate(accumulate);
+
+    pagesize = MixBufferSize * channels;
+    numbuffers = TotalBufferSize / pagesize;
+    output = malloc(numpages * pagesize);
+
+    memset(handles, 0, sizeof(handles));
+    starts = dropped = 0;
+    voicepages = 0;
+    time = 0;
+
+    // MV_StartPlayback starts on page 1, MV_ServiceVoc mixes the next one
+    mixpage = 1;
+    next = 0;
+
+    for (page = 0; page < numpages; page++)
+    {
+        while (next < numscript && script[next].page <= page)
+            PlayEvent(&script[next++]);
+
+        active = 0;
+        for (i = 0; i < MaxChannels; i++)
+            active += handles[i] && MV_VoicePlaying(handles[i]);
+        voicepages += active;
+
+        start = Seconds();
+        MV_ServiceVoc();
+        time += Seconds() - start;
+
+        mixpage = (mixpage + 1) % numbuffers;
+        memcpy(output + page * pagesize, MV_MixBuffer[mixpage], pagesize);
+    }
+
+    MV_Shutdown();
+
+    sprintf(filename, "render%d.wav", voices);
+    WriteWAV(filename, output, numpages * pagesize, mixrate, channels);
+    free(output);
+
+    printf("%6d %7d %7d %7.2f %12.0f %12.0f %9.0fx\n",
+           voices, starts, dropped, (double)voicepages / numpages,
+           numpages * (double)MixBufferSize / time,
+           voicepages * (double)MixBufferSize / time,
+           numpages * (double)MixBufferSize / mixrate / time);
+}
+
+int main(int argc, char **argv)
+{
+    char *tracefile = NULL;
+    char *wadfile = NULL;
+    char *voicelist = "4,8,16,32";
+    int seconds = 60;
+    int channels = 2;
+    int accumulate = 0;
+    unsigned long lo, hi;
+    long pagesize;
+    char *p;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-trace") && i + 1 < argc)
+            tracefile = argv[++i];
+        else if (!strcmp(argv[i], "-voices") && i + 1 < argc)
+            voicelist = argv[++i];
+        else if (!strcmp(argv[i], "-rate") && i + 1 < argc)
+            mixrate = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-seconds") && i + 1 < argc)
+            seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-mono"))
+            channels = 1;
+        else if (!strcmp(argv[i], "-accum"))
+            accumulate = 1;
+        else if (!strcmp(argv[i], "-nocache"))
+            cache = 0;
+        else
+            wadfile = argv[i];
+    }
+
+    if (wadfile)
+    {
+        wadsound_t *lumps;
+        int numlumps, j;
+
+        lumps = LoadWAD(wadfile, &numlumps);
+
+        // Same lump I_GetSfxLumpNum picks, the last one wins like in W_
+        for (i = 0; i < numlumps; i++)
+        {
+            for (j = 1; j < NUMSFX; j++)
+            {
+                if (strcasecmp(lumps[i].name + 2, S_sfx[j].name))
+                    continue;
+
+                if (!sounds[j])
+                    numsounds++;
+                sounds[j] = lumps[i].data;
+            }
+        }
+    }
+
+    if (tracefile && !numsounds)
+    {
+        printf("-trace needs the WAD the demo was played with\n");
+        return 1;
+    }
+
+    if (!numsounds)
+        numsounds = SynthSounds(sounds + 1);
+
+    if (cache)
+    {
+        for (i = 1; i < NUMSFX; i++)
+        {
+            if (sounds[i])
+                sounds[i] = CacheSound(sounds[i]);
+        }
+    }
+
+    if (tracefile)
+        LoadTrace(tracefile);
+    else
+        SynthScript(seconds);
+
+    if (!numscript)
+    {
+        printf("Nothing to play\n");
+        return 1;
+    }
+
+    // The kernels patch themselves
+    lo = hi = (unsigned long)MV_Mix8BitMono_asm;
+    for (i = 0; i < 10; i++)
+    {
+        kernel_t kernels[10] = {MV_Mix8BitMono_asm, MV_Mix8BitStereo_asm, MV_Mix8BitUltrasound_asm,
+                                MV_Mix8BitMono1_asm, MV_Mix8BitStereo1_asm, MV_Mix8BitUltrasound1_asm,
+                                MV_Accum8BitMono_asm, MV_Accum8BitStereo_asm,
+                                MV_DetectMMX_asm, MV_ClipAccumMMX_asm};
+
+        if ((unsigned long)kernels[i] < lo)
+            lo = (unsigned long)kernels[i];
+        if ((unsigned long)kernels[i] > hi)
+            hi = (unsigned long)kernels[i];
+    }
+    pagesize = sysconf(_SC_PAGESIZE);
+    lo &= ~(pagesize - 1);
+    mprotect((void *)lo, hi - lo + pagesize * 2, PROT_READ | PROT_WRITE | PROT_EXEC);
+
+    printf("%d sounds, %d events, %d pages of %d samples, %d Hz %s%s%s\n",
+           numsounds, numscript, numpages, MixBufferSize, mixrate,
+           channels == 1 ? "mono" : "stereo", accumulate ? ", accumulate" : "",
+           cache ? "" : ", no cache");
+    printf("voices  starts dropped  avg.act  samples/s  voice smp/s  realtime\n");
+
+    for (p = voicelist; *p;)
+    {
+        Render(atoi(p), channels, accumulate);
+
+        while (*p && *p != ',')
+            p++;
+        if (*p == ',')
+            p++;
+    }
+
+    return 0;
+}
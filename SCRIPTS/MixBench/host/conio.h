@@ -0,0 +1 @@
+// Host stand-in for the Watcom header, no port I/O in the mixer
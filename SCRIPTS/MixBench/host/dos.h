@@ -0,0 +1,12 @@
+// Host stand-in for the Watcom header, ns_multi.c includes it but the
+// mixer doesn't use anything from it.
+//
+// Watcom's stdlib.h has min and max, gcc doesn't
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
@@ -0,0 +1,35 @@
+#!/bin/sh
+
+# IMA ADPCM version of convert.sh, the game plays MUS_N.ADP instead of
+# MUS_N.RAW when both are present
+
+adpcm() {
+  sox $1 -r 44100 -e signed -b 16 -c 1 -t raw temp.raw
+  python3 fastdoom_adpcm.py temp.raw $2
+}
+
+adpcm D_E1M1.ogg MUS_1.ADP
+adpcm D_E1M2.ogg MUS_2.ADP
+adpcm D_E1M3.ogg MUS_3.ADP
+adpcm D_E1M4.ogg MUS_4.ADP
+adpcm D_E1M5.ogg MUS_5.ADP
+adpcm D_E1M6.ogg MUS_6.ADP
+adpcm D_E1M7.ogg MUS_7.ADP
+adpcm D_E1M8.ogg MUS_8.ADP
+adpcm D_E1M9.ogg MUS_9.ADP
+adpcm D_E2M1.ogg MUS_10.ADP
+adpcm D_E2M2.ogg MUS_11.ADP
+adpcm D_E2M3.ogg MUS_12.ADP
+adpcm D_E2M4.ogg MUS_13.ADP
+adpcm D_E2M6.ogg MUS_14.ADP
+adpcm D_E2M7.ogg MUS_15.ADP
+adpcm D_E2M8.ogg MUS_16.ADP
+adpcm D_E2M9.ogg MUS_17.ADP
+adpcm D_E3M2.ogg MUS_18.ADP
+adpcm D_E3M3.ogg MUS_19.ADP
+adpcm D_E3M8.ogg MUS_20.ADP
+adpcm D_INTER.ogg MUS_21.ADP
+adpcm D_INTRO.ogg MUS_22.ADP
+adpcm D_VICTOR.ogg MUS_23.ADP
+
+rm temp.raw
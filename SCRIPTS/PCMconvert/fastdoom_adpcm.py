@@ -0,0 +1,87 @@
+# Encodes digital music for FastDoom as IMA ADPCM (.ADP), a quarter of
+# the size of 16 bit PCM. The input is raw signed 16 bit mono, the rate
+# must match snd_pcmrate:
+#
+#   sox D_E1M1.ogg -r 44100 -e signed -b 16 -c 1 -t raw temp.raw
+#   fastdoom_adpcm.py temp.raw MUS_1.ADP
+#
+# Blocks are 1024 bytes: predictor (16 bit), step index, a pad byte and
+# 2040 samples, two per byte with the low nibble first. The last block
+# is padded with the last sample so the file loops on a block boundary.
+
+import struct
+import sys
+
+BLOCKSIZE = 1024
+BLOCKSAMPLES = (BLOCKSIZE - 4) * 2
+
+STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767]
+
+INDEXSTEP = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def encode(samples):
+    output = bytearray()
+    predictor = 0
+    index = 0
+
+    if len(samples) % BLOCKSAMPLES:
+        last = samples[-1] if samples else 0
+        samples += [last] * (BLOCKSAMPLES - len(samples) % BLOCKSAMPLES)
+
+    for start in range(0, len(samples), BLOCKSAMPLES):
+        output += struct.pack("<hBB", predictor, index, 0)
+        low = None
+
+        for sample in samples[start:start + BLOCKSAMPLES]:
+            step = STEPS[index]
+            diff = sample - predictor
+
+            code = 0
+            if diff < 0:
+                code = 8
+                diff = -diff
+            if diff >= step:
+                code |= 4
+                diff -= step
+            if diff >= step >> 1:
+                code |= 2
+                diff -= step >> 1
+            if diff >= step >> 2:
+                code |= 1
+
+            # Follow the decoder exactly (MV_DecodeADPCM)
+            diff = step >> 3
+            if code & 4:
+                diff += step
+            if code & 2:
+                diff += step >> 1
+            if code & 1:
+                diff += step >> 2
+            predictor += -diff if code & 8 else diff
+            predictor = max(-32768, min(predictor, 32767))
+            index = max(0, min(index + INDEXSTEP[code & 7], len(STEPS) - 1))
+
+            if low is None:
+                low = code
+            else:
+                output.append(low | (code << 4))
+                low = None
+
+    return output
+
+
+with open(sys.argv[1], "rb") as inputfile:
+    data = inputfile.read()
+
+count = len(data) // 2
+samples = list(struct.unpack("<%dh" % count, data[:count * 2]))
+
+with open(sys.argv[2], "wb") as outputfile:
+    outputfile.write(encode(samples))
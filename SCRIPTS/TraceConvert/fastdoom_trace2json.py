@@ -0,0 +1,91 @@
+# Converts a FastDoom TRACE.BIN dump (TRACE_ENABLED=1 builds) into
+# Chrome trace JSON, open it with chrome://tracing or ui.perfetto.dev
+#
+# Usage: fastdoom_trace2json.py TRACE.BIN trace.json
+
+import json
+import struct
+import sys
+
+TIC_BEGIN = 0
+TIC_END = 1
+STAGE_BEGIN = 2
+STAGE_END = 3
+ZONE_PURGE = 4
+LUMP_READ_BEGIN = 5
+LUMP_READ_END = 6
+COMPOSITE_BEGIN = 7
+COMPOSITE_END = 8
+SOUND_START = 9
+SOUND_STOP = 10
+
+STAGES = ["Display", "BSP", "Planes", "Masked", "Finish"]
+
+# Thread ids, just to split the timeline in rows
+TID_GAME = 1
+TID_RENDER = 2
+TID_IO = 3
+TID_SOUND = 4
+
+inputfile = open(sys.argv[1], "rb")
+data = inputfile.read()
+inputfile.close()
+
+magic, version, rate, count = struct.unpack_from("<4sIII", data, 0)
+
+if magic != b"FDTR" or version not in (1, 2):
+    sys.exit("Not a FastDoom trace file")
+
+scale = 1000000.0 / rate
+
+events = []
+
+for tid, name in ((TID_GAME, "Game"), (TID_RENDER, "Render"), (TID_IO, "Loading"), (TID_SOUND, "Sound")):
+    events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}})
+
+# Timestamps are 32 bit PIT clocks, they wrap after about an hour. Only
+# a drop of more than half the range is a wrap, events logged before
+# the PIT is set up have time 0
+wraps = 0
+last = 0
+
+for i in range(count):
+    time, kind, arg1, arg2 = struct.unpack_from("<IIii", data, 16 + i * 16)
+    if last - time > 2 ** 31:
+        wraps += 1
+    last = time
+    ts = (time + (wraps << 32)) * scale
+
+    if kind == TIC_BEGIN or kind == TIC_END:
+        events.append({"name": "Tic", "ph": "B" if kind == TIC_BEGIN else "E", "ts": ts,
+                       "pid": 1, "tid": TID_GAME, "args": {"gametic": arg1}})
+    elif kind == STAGE_BEGIN or kind == STAGE_END:
+        name = STAGES[arg1] if arg1 < len(STAGES) else "Stage %d" % arg1
+        events.append({"name": name, "ph": "B" if kind == STAGE_BEGIN else "E", "ts": ts,
+                       "pid": 1, "tid": TID_RENDER})
+    elif kind == LUMP_READ_BEGIN or kind == LUMP_READ_END:
+        events.append({"name": "Lump read", "ph": "B" if kind == LUMP_READ_BEGIN else "E", "ts": ts,
+                       "pid": 1, "tid": TID_IO, "args": {"lump": arg1, "size": arg2}})
+    elif kind == COMPOSITE_BEGIN or kind == COMPOSITE_END:
+        events.append({"name": "Composite", "ph": "B" if kind == COMPOSITE_BEGIN else "E", "ts": ts,
+                       "pid": 1, "tid": TID_IO, "args": {"texture": arg1, "size": arg2}})
+    elif kind == ZONE_PURGE:
+        events.append({"name": "Zone purge", "ph": "i", "s": "t", "ts": ts,
+                       "pid": 1, "tid": TID_IO, "args": {"size": arg1, "tag": arg2}})
+    elif kind == SOUND_START:
+        # Version 1 only had the channel
+        args = {"sfx": arg1, "channel": arg2 & 0xff}
+        if version >= 2:
+            args["volume"] = (arg2 >> 8) & 0xff
+            args["sep"] = (arg2 >> 16) & 0xff
+        events.append({"name": "Sound start", "ph": "i", "s": "t", "ts": ts,
+                       "pid": 1, "tid": TID_SOUND, "args": args})
+    elif kind == SOUND_STOP:
+        events.append({"name": "Sound stop", "ph": "i", "s": "t", "ts": ts,
+                       "pid": 1, "tid": TID_SOUND, "args": {"channel": arg1}})
+
+outputfile = open(sys.argv[2], "w")
+json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, outputfile)
+outputfile.close()
+
+print("Converted %d events" % count)
@@ -0,0 +1,575 @@
+# Builds the sector visibility tables FastDoom uses with -vis and -pvs,
+# for every map of a WAD. Writes <map>.VIS files, copy them next to
+# FASTDOOM.EXE so the maps don't have to be processed at load time.
+#
+# Same algorithm and the same 16.16 fixed point arithmetic as
+# P_BuildVisMatrix (p_sight.c), so the files are identical to the ones
+# the engine builds. Sight lines are flowed through the portals of the
+# map (two sided lines between different sectors), clipped against the
+# lines that separate the source and pass portals. Thin walls are
+# portals too, and sectors around a vertex not joined by a portal there
+# are joined by a small diamond, as sight lines grazing a wall can slip
+# through it. Lines without segs don't block sight, they join every
+# sector along them and one sided ones the void behind them. Heights
+# are ignored.
+#
+# Usage: fastdoom_vis.py DOOM.WAD [outputdir]
+
+import os
+import struct
+import sys
+
+FRACBITS = 16
+FRACUNIT = 1 << FRACBITS
+MAXINT = 0x7FFFFFFF
+MININT = -0x80000000
+
+EPSILON = 4 * FRACUNIT
+TOLERANCE = FRACUNIT // 16
+MAXDEPTH = 64
+MAXSTEPS = 65536
+MAXSEPARATORS = 16
+VERSION = 3
+
+ML_TWOSIDED = 4
+NF_SUBSECTOR = 0x8000
+
+MAPLUMPS = ["THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS",
+            "SSECTORS", "NODES", "SECTORS", "REJECT", "BLOCKMAP"]
+
+
+# 32 bit int arithmetic, as the engine does it
+
+def int32(value):
+    value &= 0xFFFFFFFF
+    return value - 0x100000000 if value & 0x80000000 else value
+
+
+def iabs(value):
+    return int32(-value) if value < 0 else value
+
+
+def fixed_mul(a, b):
+    return int32((a * b) >> FRACBITS)
+
+
+def fixed_div(a, b):
+    if (iabs(a) >> 14) >= iabs(b):
+        return MININT if (a ^ b) < 0 else MAXINT
+
+    # idiv rounds towards zero
+    q = abs(a * FRACUNIT) // abs(b)
+    return int32(-q if (a < 0) != (b < 0) else q)
+
+
+def aprox_distance(dx, dy):
+    dx = iabs(dx)
+    dy = iabs(dy)
+    return int32(dx + dy - (min(dx, dy) >> 1))
+
+
+def read_wad(filename):
+    wadfile = open(filename, "rb")
+    data = wadfile.read()
+    wadfile.close()
+
+    identification, numlumps, infotableofs = struct.unpack_from("<4sii", data, 0)
+
+    if identification not in (b"IWAD", b"PWAD"):
+        sys.exit("Not a WAD file")
+
+    lumps = []
+    for i in range(numlumps):
+        filepos, size, name = struct.unpack_from("<ii8s", data, infotableofs + i * 16)
+        name = name.split(b"\0")[0].decode("ascii", "replace").upper()
+        lumps.append((name, data[filepos:filepos + size]))
+
+    return lumps
+
+
+def is_map(lumps, i):
+    if i + len(MAPLUMPS) >= len(lumps):
+        return False
+
+    for j, name in enumerate(MAPLUMPS):
+        if lumps[i + 1 + j][0] != name:
+            return False
+
+    return True
+
+
+class Map:
+    def __init__(self, lumps, i):
+        self.name = lumps[i][0]
+
+        data = lumps[i + 4][1]
+        self.vertexes = [struct.unpack_from("<hh", data, j * 4) for j in range(len(data) // 4)]
+
+        data = lumps[i + 3][1]
+        sidesectors = [struct.unpack_from("<h", data, j * 30 + 28)[0] for j in range(len(data) // 30)]
+
+        self.numsectors = len(lumps[i + 8][1]) // 26
+        self.reject = lumps[i + 9][1]
+
+        data = lumps[i + 2][1]
+        self.lines = []
+        sidenums = []
+        for j in range(len(data) // 14):
+            v1, v2, flags, special, tag, side0, side1 = struct.unpack_from("<HHhhhhh", data, j * 14)
+            front = sidesectors[side0] if side0 != -1 else -1
+            back = sidesectors[side1] if side1 != -1 else -1
+            self.lines.append((v1, v2, flags, front, back))
+            sidenums.append((side0, side1))
+
+        # Lines with segs and the sector of every subsector, as P_LoadSegs,
+        # P_LoadSubsectors and P_GroupLines
+        data = lumps[i + 5][1]
+        seglines = [struct.unpack_from("<HHhHhh", data, j * 12)[3:5] for j in range(len(data) // 12)]
+
+        data = lumps[i + 6][1]
+        self.subsectors = []
+        self.linesegs = [0] * len(self.lines)
+        for j in range(len(data) // 4):
+            numsegs, firstseg = struct.unpack_from("<hh", data, j * 4)
+            linedef, side = seglines[firstseg]
+            self.subsectors.append(sidesectors[sidenums[linedef][side]])
+            for k in range(firstseg, firstseg + numsegs):
+                self.linesegs[seglines[k][0]] = 1
+
+        # x, y, dx, dy and the children
+        data = lumps[i + 7][1]
+        self.nodes = []
+        for j in range(len(data) // 28):
+            node = struct.unpack_from("<hhhh8hHH", data, j * 28)
+            self.nodes.append(node[0:4] + node[12:14])
+
+    def fixed_vertex(self, v):
+        x, y = self.vertexes[v]
+        return x << FRACBITS, y << FRACBITS
+
+    # Must match P_VisHash
+    def hash(self):
+        h = 2166136261
+
+        def add(value):
+            return ((h ^ (value & 0xFFFFFFFF)) * 16777619) & 0xFFFFFFFF
+
+        h = add(self.numsectors)
+        h = add(len(self.lines))
+        h = add(len(self.subsectors))
+
+        for i, (v1, v2, flags, front, back) in enumerate(self.lines):
+            h = add(self.vertexes[v1][0])
+            h = add(self.vertexes[v1][1])
+            h = add(self.vertexes[v2][0])
+            h = add(self.vertexes[v2][1])
+            h = add(flags)
+            h = add(front)
+            h = add(back)
+            h = add(self.linesegs[i])
+
+        return h
+
+
+# Lines are (nx, ny, d), see P_MakeVisLine
+def make_line(x1, y1, x2, y2):
+    dx = int32(x2 - x1)
+    dy = int32(y2 - y1)
+    length = aprox_distance(dx, dy)
+
+    if length < TOLERANCE:
+        return None
+
+    nx = fixed_div(int32(-dy), length)
+    ny = fixed_div(dx, length)
+    return (nx, ny, int32(fixed_mul(nx, x1) + fixed_mul(ny, y1)))
+
+
+# Distance to the line, positive to the left
+def side(line, point):
+    return int32(fixed_mul(line[0], point[0]) + fixed_mul(line[1], point[1]) - line[2])
+
+
+def flip(line):
+    return (int32(-line[0]), int32(-line[1]), int32(-line[2]))
+
+
+# P_VisSeparator
+def separator(s, p, source, window):
+    line = make_line(s[0], s[1], p[0], p[1])
+
+    if line is None:
+        return None
+
+    ds = [side(line, point) for point in source]
+    dp = [side(line, point) for point in window]
+    mins, maxs = min(ds), max(ds)
+    minp, maxp = min(dp), max(dp)
+
+    if maxs <= TOLERANCE and minp >= -TOLERANCE and mins < -TOLERANCE and maxp > TOLERANCE:
+        return line
+
+    if mins >= -TOLERANCE and maxp <= TOLERANCE and maxs > TOLERANCE and minp < -TOLERANCE:
+        return flip(line)
+
+    return None
+
+
+class Portal:
+    def __init__(self, points, sectors, line, vertex, oriented, slack):
+        self.points = points
+        self.sectors = sectors
+        self.line = line          # None for the vertex diamonds
+        self.vertex = vertex      # -1 for line portals
+        self.oriented = oriented  # sectors[0] on the right of the line
+        self.slack = slack        # TOLERANCE as a fraction of the portal
+
+
+class Vis:
+    def __init__(self, level):
+        self.level = level
+        self.numsectors = level.numsectors
+        self.numvissectors = level.numsectors + 1  # and the void
+        self.build_portals()
+
+    # P_VisNodeSide
+    def node_side(self, node, v):
+        x, y = self.level.vertexes[v]
+        left = fixed_mul(node[3] << 7, (x - node[0]) << 7)
+        right = fixed_mul((y - node[1]) << 7, node[2] << 7)
+
+        if iabs(int32(left - right)) <= 1:
+            return 2
+
+        return 1 if right >= left else 0
+
+    # P_VisLineSectors
+    def line_sectors(self, bspnum, v1, v2, sectors):
+        if bspnum & NF_SUBSECTOR:
+            sector = self.level.subsectors[bspnum & ~NF_SUBSECTOR]
+            if sector not in sectors:
+                sectors.append(sector)
+            return
+
+        node = self.level.nodes[bspnum]
+        side1 = self.node_side(node, v1)
+        side2 = self.node_side(node, v2)
+
+        if side1 != 1 and side2 != 1:
+            self.line_sectors(node[4], v1, v2, sectors)
+
+        if side1 != 0 and side2 != 0:
+            self.line_sectors(node[5], v1, v2, sectors)
+
+    # P_VisSeglessSectors
+    def segless_sectors(self, v1, v2, front, back):
+        sectors = []
+
+        if front != -1:
+            sectors.append(front)
+
+        if back != -1 and back not in sectors:
+            sectors.append(back)
+
+        if back == -1:
+            sectors.append(self.numsectors)
+
+        firstnode = len(self.level.nodes) - 1
+        self.line_sectors(NF_SUBSECTOR if firstnode == -1 else firstnode, v1, v2, sectors)
+        return sectors
+
+    # P_BuildVisPortals. Links are (portal, other sector, plane) and are
+    # numbered per sector like vislinks, plane is the half plane sight
+    # lines are in after crossing the portal
+    def build_portals(self):
+        level = self.level
+        vertexsectors = [[] for v in level.vertexes]
+        vertexpairs = [set() for v in level.vertexes]
+        onesided = {}
+
+        self.portals = []
+
+        def add_portal(v1, v2, front, back, oriented):
+            p1 = level.fixed_vertex(v1)
+            p2 = level.fixed_vertex(v2)
+            line = make_line(p1[0], p1[1], p2[0], p2[1])
+
+            if line is None:
+                return
+
+            slack = fixed_div(TOLERANCE, aprox_distance(int32(p2[0] - p1[0]), int32(p2[1] - p1[1])))
+            self.portals.append(Portal((p1, p2), (front, back), line, -1, oriented, slack))
+
+            for v in (v1, v2):
+                vertexpairs[v].add((front, back))
+                vertexpairs[v].add((back, front))
+
+        for v1, v2, flags, front, back in level.lines:
+            for v in (v1, v2):
+                for sector in (front, back):
+                    if sector != -1 and sector not in vertexsectors[v]:
+                        vertexsectors[v].append(sector)
+
+        for i, (v1, v2, flags, front, back) in enumerate(level.lines):
+            twosided = (flags & ML_TWOSIDED) and back != -1
+
+            if not level.linesegs[i]:
+                # Sight lines cross it between any of the sectors along
+                # it, which side each one is on isn't known
+                sectors = self.segless_sectors(v1, v2, front, back)
+
+                for j in range(len(sectors)):
+                    for k in range(j + 1, len(sectors)):
+                        add_portal(v1, v2, sectors[j], sectors[k], False)
+            elif twosided:
+                if front != -1 and front != back:
+                    add_portal(v1, v2, front, back, True)
+            elif front != -1:
+                # Thin walls, sight lines can slip through them at any
+                # point when grazing, so they are portals too
+                other = onesided.get((v2, v1))
+                if other is not None and other != front:
+                    add_portal(v1, v2, front, other, True)
+
+            # Every one sided line is a thin wall candidate for the next
+            # ones, as P_ThinWallSector
+            if not twosided and front != -1:
+                onesided[(v1, v2)] = front
+
+        for v, sectors in enumerate(vertexsectors):
+            x, y = level.fixed_vertex(v)
+            diamond = ((x - EPSILON, y), (x, y - EPSILON), (x + EPSILON, y), (x, y + EPSILON))
+
+            for i in range(len(sectors)):
+                for j in range(i + 1, len(sectors)):
+                    if (sectors[i], sectors[j]) not in vertexpairs[v]:
+                        self.portals.append(Portal(diamond, (sectors[i], sectors[j]), None, v, False, 0))
+
+        self.links = [[] for s in range(self.numvissectors)]
+
+        for i, portal in enumerate(self.portals):
+            line = portal.line if portal.oriented else None
+            self.links[portal.sectors[0]].append((i, portal.sectors[1], line))
+            self.links[portal.sectors[1]].append((i, portal.sectors[0], flip(line) if line else None))
+
+    # P_VisClip, returns the range left along the portal, diamonds are
+    # never clipped, or None
+    def clip(self, portal, planes):
+        points = portal.points
+
+        if portal.line is None:
+            for plane in planes:
+                if max(side(plane, point) for point in points) < -TOLERANCE:
+                    return None
+            return 0, FRACUNIT
+
+        t0 = 0
+        t1 = FRACUNIT
+
+        for plane in planes:
+            d0 = int32(side(plane, points[0]) + TOLERANCE)
+            d1 = int32(side(plane, points[1]) + TOLERANCE)
+
+            if d0 < 0 and d1 < 0:
+                return None
+
+            if d0 < 0:
+                t0 = max(t0, fixed_div(d0, int32(d0 - d1)))
+            elif d1 < 0:
+                t1 = min(t1, fixed_div(d0, int32(d0 - d1)))
+
+            if t0 > t1:
+                return None
+
+        return t0, t1
+
+    # P_VisWindow
+    @staticmethod
+    def window(portal, t0, t1):
+        if portal.line is None:
+            return portal.points
+
+        (x1, y1), (x2, y2) = portal.points
+        dx = int32(x2 - x1)
+        dy = int32(y2 - y1)
+        return ((int32(x1 + fixed_mul(dx, t0)), int32(y1 + fixed_mul(dy, t0))),
+                (int32(x1 + fixed_mul(dx, t1)), int32(y1 + fixed_mul(dy, t1))))
+
+    # P_VisSkip
+    def skip(self, portal, passportal):
+        if portal is passportal:
+            return True
+
+        if passportal.line is None:
+            return portal.vertex == passportal.vertex
+
+        if portal.line is None:
+            return False
+
+        return iabs(side(passportal.line, portal.points[0])) <= TOLERANCE and \
+            iabs(side(passportal.line, portal.points[1])) <= TOLERANCE
+
+    # P_VisBehind
+    @staticmethod
+    def behind(plane, points):
+        return plane is not None and min(side(plane, point) for point in points) > TOLERANCE
+
+    # P_VisExplored
+    def explored(self, link, t0, t1):
+        previous = self.windows.get(link)
+        slack = self.portals[link[1]].slack
+
+        if previous is not None:
+            if previous[0] <= int32(t0 + slack) and t1 <= int32(previous[1] + slack):
+                return True
+            if int32(t1 - t0) <= int32(previous[1] - previous[0]):
+                return False
+
+        self.windows[link] = (t0, t1)
+        return False
+
+    # P_VisFlow
+    def flow(self, source, sourceplane, passportal, window, passplane, sector, depth):
+        planes = [plane for plane in (sourceplane, passplane) if plane is not None]
+
+        for s in source:
+            for p in window:
+                if len(planes) == 2 + MAXSEPARATORS:
+                    break
+                line = separator(s, p, source, window)
+                if line is not None:
+                    planes.append(line)
+
+        for index, (portalnum, other, plane) in enumerate(self.links[sector]):
+            portal = self.portals[portalnum]
+
+            if self.skip(portal, passportal) or self.behind(plane, source) or self.behind(plane, window):
+                continue
+
+            self.steps += 1
+            if self.steps > MAXSTEPS:
+                self.overflow = True
+                return
+
+            clipped = self.clip(portal, planes)
+            if clipped is None:
+                continue
+
+            self.visible.add(other)
+
+            if self.explored((sector, portalnum, index), clipped[0], clipped[1]):
+                continue
+
+            if depth == MAXDEPTH:
+                self.overflow = True
+                return
+
+            self.flow(source, sourceplane, portal, self.window(portal, clipped[0], clipped[1]), plane, other, depth + 1)
+
+            if self.overflow:
+                return
+
+    # P_VisConnected, every sector reachable through portals
+    def connected(self, source):
+        visible = set([source])
+        stack = [source]
+
+        while stack:
+            sector = stack.pop()
+            for portalnum, other, plane in self.links[sector]:
+                if other not in visible:
+                    visible.add(other)
+                    stack.append(other)
+
+        return visible
+
+    # P_VisSector
+    def sector_visibility(self, source):
+        self.visible = set([source])
+        self.steps = 0
+        self.overflow = False
+
+        for portalnum1, sector1, plane1 in self.links[source]:
+            portal1 = self.portals[portalnum1]
+
+            self.visible.add(sector1)
+            self.windows = {}
+
+            # Any line crossing two portals exists
+            for index, (portalnum2, sector2, plane2) in enumerate(self.links[sector1]):
+                portal2 = self.portals[portalnum2]
+
+                if self.skip(portal2, portal1) or self.behind(plane2, portal1.points):
+                    continue
+
+                clipped = self.clip(portal2, [plane1] if plane1 else [])
+                if clipped is None:
+                    continue
+
+                self.visible.add(sector2)
+
+                if self.explored((sector1, portalnum2, index), clipped[0], clipped[1]):
+                    continue
+
+                self.flow(portal1.points, plane1, portal2, self.window(portal2, clipped[0], clipped[1]), plane2, sector2, 2)
+
+                if self.overflow:
+                    return self.connected(source), True
+
+        return self.visible, False
+
+    # Bits set for sector pairs that can't see each other, REJECT layout
+    def build(self):
+        n = self.numsectors
+        visible = []
+        overflows = 0
+
+        for source in range(n):
+            sectors, overflow = self.sector_visibility(source)
+            visible.append(sectors)
+            overflows += overflow
+
+        reject = bytearray((n * n + 7) >> 3)
+
+        # Sight is symmetric, only reject pairs hidden both ways
+        for a in range(n):
+            for b in range(n):
+                if b not in visible[a] and a not in visible[b]:
+                    pnum = a * n + b
+                    reject[pnum >> 3] |= 1 << (pnum & 7)
+
+        return reject, overflows
+
+
+def count_bits(data, n):
+    total = 0
+    for pnum in range(n * n):
+        if pnum >> 3 < len(data) and data[pnum >> 3] & (1 << (pnum & 7)):
+            total += 1
+    return total
+
+
+if len(sys.argv) < 2:
+    sys.exit("Usage: fastdoom_vis.py DOOM.WAD [outputdir]")
+
+outputdir = sys.argv[2] if len(sys.argv) > 2 else "."
+lumps = read_wad(sys.argv[1])
+
+for i in range(len(lumps)):
+    if not is_map(lumps, i):
+        continue
+
+    level = Map(lumps, i)
+    reject, overflows = Vis(level).build()
+    n = level.numsectors
+
+    outputfile = open(os.path.join(outputdir, level.name + ".VIS"), "wb")
+    outputfile.write(struct.pack("<4siiI", b"FDVS", VERSION, n, level.hash()))
+    outputfile.write(reject)
+    outputfile.close()
+
+    original = count_bits(level.reject, n)
+    merged = count_bits(bytes(a | b for a, b in zip(reject, level.reject.ljust(len(reject), b"\0"))), n)
+
+    print("%-8s %5d sectors, REJECT %5.1f%%, with vis %5.1f%%, %d fallback sources" %
+          (level.name, n, original * 100.0 / (n * n), merged * 100.0 / (n * n), overflows))
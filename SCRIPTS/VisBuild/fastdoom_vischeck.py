@@ -0,0 +1,193 @@
+# Map load check for the sector visibility tables. Writes a Doom II
+# PWAD whose MAP01 has N spike sectors (12 by default) touching only at
+# one vertex, with the void between them. Sight lines between spikes
+# only pass through that vertex, so the diamond portals there are the
+# only thing joining them and no pair of sectors may be rejected.
+#
+# Usage: fastdoom_vischeck.py VISCHECK.WAD [sectors]
+#        fastdoom_vischeck.py MAP01.VIS
+#
+# Load the map with "FDOOM -iwad DOOM2.WAD -file VISCHECK.WAD -warp 1
+# -vis" (or run fastdoom_vis.py on the WAD) and check the MAP01.VIS it
+# writes with the second form.
+
+import math
+import struct
+import sys
+
+RADIUS = 512
+HALFWIDTH = 0.1
+BLOCKSIZE = 128
+
+
+def spike_vertexes(n):
+    # Opposite spikes are exact mirrors, so the partition lines through
+    # the shared vertex never split a spike
+    a = []
+    b = []
+
+    for i in range(n // 2):
+        t = math.pi * i / (n // 2)
+        a.append((int(round(RADIUS * math.cos(t - HALFWIDTH))), int(round(RADIUS * math.sin(t - HALFWIDTH)))))
+        b.append((int(round(RADIUS * math.cos(t + HALFWIDTH))), int(round(RADIUS * math.sin(t + HALFWIDTH)))))
+
+    return a + [(-x, -y) for x, y in a], b + [(-x, -y) for x, y in b]
+
+
+def seg_angle(v1, v2):
+    return int(math.atan2(v2[1] - v1[1], v2[0] - v1[0]) * 32768 / math.pi) & 0xffff
+
+
+def bounding_box(points):
+    xs = [p[0] for p in points]
+    ys = [p[1] for p in points]
+    return max(ys), min(ys), min(xs), max(xs)
+
+
+def write_wad(filename, n):
+    a, b = spike_vertexes(n)
+    vertexes = [(0, 0)]
+    lines = []
+    segs = []
+    subsectors = []
+    nodes = []
+
+    # Spike i is the triangle (0, a[i], b[i]), its lines run clockwise so
+    # the sector is on their right
+    for i in range(n):
+        va = 1 + 2 * i
+        vb = 2 + 2 * i
+        vertexes += [a[i], b[i]]
+        first = len(segs)
+
+        for v1, v2 in ((0, vb), (vb, va), (va, 0)):
+            lines.append((v1, v2))
+            segs.append((v1, v2, seg_angle(vertexes[v1], vertexes[v2]), len(lines) - 1, 0, 0))
+
+        subsectors.append((3, first))
+
+    def centroid(s):
+        return (a[s][0] + b[s][0]) / 3.0, (a[s][1] + b[s][1]) / 3.0
+
+    def build(spikes):
+        if len(spikes) == 1:
+            points = [(0, 0), a[spikes[0]], b[spikes[0]]]
+            return spikes[0] | 0x8000, bounding_box(points)
+
+        # A partition line along a spike edge, through the shared vertex
+        for k in range(n):
+            dx, dy = a[k]
+            front = [s for s in spikes if dy * centroid(s)[0] > centroid(s)[1] * dx]
+            back = [s for s in spikes if s not in front]
+
+            if front and back and abs(len(front) - len(back)) <= 1:
+                break
+
+        frontchild, frontbox = build(front)
+        backchild, backbox = build(back)
+        nodes.append((0, 0, dx, dy) + frontbox + backbox + (frontchild, backchild))
+
+        return len(nodes) - 1, (max(frontbox[0], backbox[0]), min(frontbox[1], backbox[1]),
+                                min(frontbox[2], backbox[2]), max(frontbox[3], backbox[3]))
+
+    build(list(range(n)))
+
+    # Every line goes in each block its bounding box touches
+    top, bottom, left, right = bounding_box(vertexes)
+    left -= 8
+    bottom -= 8
+    columns = (right - left) // BLOCKSIZE + 1
+    rows = (top - bottom) // BLOCKSIZE + 1
+    blocklists = []
+
+    for row in range(rows):
+        for column in range(columns):
+            x1 = left + column * BLOCKSIZE
+            y1 = bottom + row * BLOCKSIZE
+            blocklist = [0]
+
+            for i, (v1, v2) in enumerate(lines):
+                p1 = vertexes[v1]
+                p2 = vertexes[v2]
+
+                if (max(p1[0], p2[0]) >= x1 and min(p1[0], p2[0]) < x1 + BLOCKSIZE and
+                        max(p1[1], p2[1]) >= y1 and min(p1[1], p2[1]) < y1 + BLOCKSIZE):
+                    blocklist.append(i)
+
+            blocklists.append(blocklist + [-1])
+
+    offset = 4 + columns * rows
+    blockmap = [left, bottom, columns, rows]
+
+    for blocklist in blocklists:
+        blockmap.append(offset)
+        offset += len(blocklist)
+
+    for blocklist in blocklists:
+        blockmap += blocklist
+
+    start = centroid(0)
+
+    lumps = [
+        ("MAP01", b""),
+        ("THINGS", struct.pack("<hhhhh", int(start[0]), int(start[1]), 0, 1, 7)),
+        ("LINEDEFS", b"".join(struct.pack("<HHhhhhh", v1, v2, 1, 0, 0, i, -1) for i, (v1, v2) in enumerate(lines))),
+        ("SIDEDEFS", b"".join(struct.pack("<hh8s8s8sh", 0, 0, b"-", b"-", b"STARTAN3", i // 3) for i in range(len(lines)))),
+        ("VERTEXES", b"".join(struct.pack("<hh", x, y) for x, y in vertexes)),
+        ("SEGS", b"".join(struct.pack("<HHHHhh", *seg) for seg in segs)),
+        ("SSECTORS", b"".join(struct.pack("<hh", *subsector) for subsector in subsectors)),
+        ("NODES", b"".join(struct.pack("<hhhh8hHH", *node) for node in nodes)),
+        ("SECTORS", struct.pack("<hh8s8shhh", 0, 128, b"FLOOR4_8", b"CEIL3_5", 192, 0, 0) * n),
+        ("REJECT", b""),
+        ("BLOCKMAP", b"".join(struct.pack("<h", value) for value in blockmap)),
+    ]
+
+    data = b""
+    directory = b""
+    offset = 12
+
+    for name, lump in lumps:
+        directory += struct.pack("<ii8s", offset, len(lump), name.encode("ascii"))
+        data += lump
+        offset += len(lump)
+
+    wadfile = open(filename, "wb")
+    wadfile.write(struct.pack("<4sii", b"PWAD", len(lumps), offset) + data + directory)
+    wadfile.close()
+
+    print("%s: MAP01 with %d sectors around one vertex" % (filename, n))
+
+
+def check_vis(filename):
+    visfile = open(filename, "rb")
+    data = visfile.read()
+    visfile.close()
+
+    identification, version, n, maphash = struct.unpack_from("<4siiI", data, 0)
+
+    if identification != b"FDVS":
+        sys.exit("Not a VIS file")
+
+    reject = data[16:]
+    rejected = [(s1, s2) for s1 in range(n) for s2 in range(n)
+                if reject[(s1 * n + s2) >> 3] & (1 << ((s1 * n + s2) & 7))]
+
+    if rejected:
+        sys.exit("%s: %d of %d sector pairs rejected, first %d-%d" % (filename, len(rejected), n * n, rejected[0][0],
+                                                                      rejected[0][1]))
+
+    print("%s: %d sectors, no pair rejected" % (filename, n))
+
+
+if len(sys.argv) < 2:
+    sys.exit("Usage: fastdoom_vischeck.py VISCHECK.WAD [sectors] | MAP01.VIS")
+
+if sys.argv[1].upper().endswith(".VIS"):
+    check_vis(sys.argv[1])
+else:
+    sectors = int(sys.argv[2]) if len(sys.argv) > 2 else 12
+
+    if sectors < 2 or sectors & 1:
+        sys.exit("The number of sectors must be even")
+
+    write_wad(sys.argv[1], sectors)
@@ -164,6 +164,21 @@ else
 
 fi
 
+if [[ "$RENDERSTATS_ENABLED" -eq 1 ]]; then
+  echo "Enabling renderer workload counters (saved on advanced benchmarks)"
+  buildopts="$buildopts -dRENDERSTATS_ENABLED=1"
+fi
+
+if [[ "$PROFILER_ENABLED" -eq 1 ]]; then
+  echo "Enabling timer sampling profiler (PROFILE.TXT, needs the .map file)"
+  buildopts="$buildopts -dPROFILER_ENABLED=1"
+fi
+
+if [[ "$TRACE_ENABLED" -eq 1 ]]; then
+  echo "Enabling binary event trace (TRACE.BIN, convert with SCRIPTS/TraceConvert)"
+  buildopts="$buildopts -dTRACE_ENABLED=1"
+fi
+
 if [[ "$DEBUG_ENABLED" -eq 1 ]]; then
   echo "Enabling debug symbols, traceable stack frames, and debug logging/checks"
   wccbuildopts="$buildopts -d2 -of+ -dDEBUG_ENABLED=1"
@@ -203,8 +218,8 @@ else
 fi
 yes | cp -rf fdoom.exe "../${target^^}"
 
-# Copy corresponding .map file if it exists and debug enabled
-if [[ "$DEBUG_ENABLED" -eq 1 ]]; then
+# Copy corresponding .map file if it exists and debug or profiler enabled
+if [[ "$DEBUG_ENABLED" -eq 1 || "$PROFILER_ENABLED" -eq 1 ]]; then
   echo "Copying map file"
   mapfile="fdoom.map"
   echo $mapfile